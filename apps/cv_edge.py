@@ -3,7 +3,7 @@ import sys
 import cv2
 import numpy as np
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import run_filter, add_encode_option, set_encode_policy
 
 def main():
     parser = argparse.ArgumentParser(description="Apply edge detection to an image.")
@@ -26,41 +26,41 @@ def main():
     parser.add_argument("--direction", "-d", choices=['x', 'y', 'both'], default='both',
                        help="Sobel: Gradient direction (default: both)")
     
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
-    # Read image
-    img = read_image(args.input_path)
-    if img is None:
-        sys.stderr.write("Error: No input image provided.\n")
-        sys.exit(1)
+    def detect_edges(img):
+        # Convert to grayscale if needed
+        if len(img.shape) == 3:
+            gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
+        else:
+            gray = img
 
-    # Convert to grayscale if needed
-    if len(img.shape) == 3:
-        gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
-    else:
-        gray = img
-
-    # Apply edge detection based on method
-    if args.method == 'canny':
-        edges = cv2.Canny(gray, args.threshold1, args.threshold2)
-        
-    elif args.method == 'sobel':
-        if args.direction == 'x':
-            edges = cv2.Sobel(gray, cv2.CV_64F, 1, 0, ksize=args.ksize)
-            edges = np.uint8(np.absolute(edges))
-        elif args.direction == 'y':
-            edges = cv2.Sobel(gray, cv2.CV_64F, 0, 1, ksize=args.ksize)
-            edges = np.uint8(np.absolute(edges))
-        else:  # both
-            sobelx = cv2.Sobel(gray, cv2.CV_64F, 1, 0, ksize=args.ksize)
-            sobely = cv2.Sobel(gray, cv2.CV_64F, 0, 1, ksize=args.ksize)
-            edges = np.uint8(np.sqrt(sobelx**2 + sobely**2))
+        # Apply edge detection based on method
+        if args.method == 'canny':
+            edges = cv2.Canny(gray, args.threshold1, args.threshold2)
             
-    elif args.method == 'laplacian':
-        edges = cv2.Laplacian(gray, cv2.CV_64F, ksize=args.ksize)
-        edges = np.uint8(np.absolute(edges))
+        elif args.method == 'sobel':
+            if args.direction == 'x':
+                edges = cv2.Sobel(gray, cv2.CV_64F, 1, 0, ksize=args.ksize)
+                edges = np.uint8(np.absolute(edges))
+            elif args.direction == 'y':
+                edges = cv2.Sobel(gray, cv2.CV_64F, 0, 1, ksize=args.ksize)
+                edges = np.uint8(np.absolute(edges))
+            else:  # both
+                sobelx = cv2.Sobel(gray, cv2.CV_64F, 1, 0, ksize=args.ksize)
+                sobely = cv2.Sobel(gray, cv2.CV_64F, 0, 1, ksize=args.ksize)
+                edges = np.uint8(np.sqrt(sobelx**2 + sobely**2))
+                
+        elif args.method == 'laplacian':
+            edges = cv2.Laplacian(gray, cv2.CV_64F, ksize=args.ksize)
+            edges = np.uint8(np.absolute(edges))
+
+        return edges
 
-    write_image(edges, args.output)
+    # Works on a single image or on every frame of a stream/video
+    run_filter(args.input_path, args.output, detect_edges)
 
 if __name__ == "__main__":
     main()
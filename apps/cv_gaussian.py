@@ -2,7 +2,7 @@
 import sys
 import cv2
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import run_filter, add_encode_option, set_encode_policy
 
 def main():
     parser = argparse.ArgumentParser(description="Apply Gaussian blur to an image.")
@@ -11,23 +11,18 @@ def main():
     parser.add_argument("--kernel", "-k", type=int, default=5, help="Kernel size (must be odd, default: 5)")
     parser.add_argument("--sigma", "-s", type=float, default=0, help="Gaussian kernel standard deviation (default: 0)")
     
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
     # Validate kernel size
     if args.kernel % 2 == 0:
         sys.stderr.write("Warning: Kernel size must be odd. Adding 1.\n")
         args.kernel += 1
 
-    img = read_image(args.input_path)
-    
-    if img is None:
-        sys.stderr.write("Error: No input image provided.\n")
-        sys.exit(1)
-
-    # Apply Gaussian Blur
-    blurred = cv2.GaussianBlur(img, (args.kernel, args.kernel), args.sigma)
-
-    write_image(blurred, args.output)
+    # Apply Gaussian Blur to the image or to every frame of a stream
+    run_filter(args.input_path, args.output,
+               lambda img: cv2.GaussianBlur(img, (args.kernel, args.kernel), args.sigma))
 
 if __name__ == "__main__":
     main()
@@ -3,7 +3,7 @@ import sys
 import cv2
 import numpy as np
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import run_filter, add_encode_option, set_encode_policy
 
 def main():
     parser = argparse.ArgumentParser(description="Harris corner detection on an image.")
@@ -14,34 +14,33 @@ def main():
     parser.add_argument("--k", type=float, default=0.04, help="Harris detector free parameter (default: 0.04)")
     parser.add_argument("--threshold", type=float, default=0.01, help="Threshold for detecting corners (default: 0.01)")
 
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
-    # Read image
-    img = read_image(args.input_path)
-    if img is None:
-        sys.stderr.write("Error: No input image provided.\n")
-        sys.exit(1)
+    def mark_corners(img):
+        # Convert to grayscale if necessary
+        if len(img.shape) == 3 and img.shape[2] == 3:
+            gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
+        else:
+            gray = img
 
-    # Convert to grayscale if necessary
-    if len(img.shape) == 3 and img.shape[2] == 3:
-        gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
-    else:
-        gray = img
+        gray = np.float32(gray)
 
-    gray = np.float32(gray)
+        # Apply Harris corner detection
+        dst = cv2.cornerHarris(gray, blockSize=args.blockSize, ksize=args.ksize, k=args.k)
 
-    # Apply Harris corner detection
-    dst = cv2.cornerHarris(gray, blockSize=args.blockSize, ksize=args.ksize, k=args.k)
+        # Dilate to mark corners
+        dst = cv2.dilate(dst, None)
 
-    # Dilate to mark corners
-    dst = cv2.dilate(dst, None)
+        # Create output image with corners marked in red
+        output_img = cv2.cvtColor(gray.astype(np.uint8), cv2.COLOR_GRAY2BGR)
+        output_img[dst > args.threshold * dst.max()] = [0, 0, 255]
 
-    # Create output image with corners marked in red
-    output_img = cv2.cvtColor(gray.astype(np.uint8), cv2.COLOR_GRAY2BGR)
-    output_img[dst > args.threshold * dst.max()] = [0, 0, 255]
+        return output_img
 
-    # Save/output
-    write_image(output_img, args.output)
+    # Save/output (single image or frame stream)
+    run_filter(args.input_path, args.output, mark_corners)
 
 if __name__ == "__main__":
     main()
@@ -2,7 +2,7 @@ import sys
 import argparse
 import cv2
 import numpy as np
-from cv_utils import read_image, write_image
+from cv_utils import run_filter, add_encode_option, set_encode_policy
 
 
 def adjust_hsv(img, hue_shift=0, sat_scale=1.0, val_scale=1.0):
@@ -34,21 +34,17 @@ def main():
     parser.add_argument("--s", type=float, default=1.0, help="Saturation scale (default: 1.0)")
     parser.add_argument("--v", type=float, default=1.0, help="Value / brightness scale (default: 1.0)")
     parser.add_argument("-o", "--output", required=True,help="Output image path")
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
-    img = read_image(args.image_path)
-    if img is None:
-        sys.stderr.write("Error: Could not read image\n")
-        sys.exit(1)
-
-    out = adjust_hsv(
+    # Image path may also be a video or a directory of frames
+    run_filter(args.image_path, args.output, lambda img: adjust_hsv(
         img,
         hue_shift=args.h,
         sat_scale=args.s,
         val_scale=args.v
-    )
-
-    write_image(out, args.output)
+    ))
 
 
 if __name__ == "__main__":
@@ -1,6 +1,9 @@
 import sys
+import os
+import time
 import argparse
 from cv_utils import read_image
+from img_probe import probe_image
 
 
 
@@ -18,6 +21,31 @@ def print_basic_info(img, path):
     print()
 
 
+ORIENTATIONS = {
+    1: "normal", 2: "mirrored", 3: "rotated 180", 4: "mirrored + rotated 180",
+    5: "mirrored + rotated 90 CCW", 6: "rotated 90 CW", 7: "mirrored + rotated 90 CW",
+    8: "rotated 90 CCW",
+}
+
+
+def print_header_info(info, path):
+    """Basic info straight from the file header, without decoding pixels."""
+    st = os.stat(path)
+
+    print("=== Basic Image Info ===")
+    print(f"Path          : {path}")
+    print(f"Format        : {info['format']}")
+    print(f"Width         : {info['width']}")
+    print(f"Height        : {info['height']}")
+    print(f"Channels      : {info['channels']}")
+    print(f"Bit depth     : {info['bit_depth']}")
+    print(f"Orientation   : {ORIENTATIONS.get(info['orientation'], 'unknown')}")
+    print(f"Total pixels  : {info['width'] * info['height']}")
+    print(f"File size     : {st.st_size} bytes")
+    print(f"Modified      : {time.strftime('%Y-%m-%d %H:%M:%S', time.localtime(st.st_mtime))}")
+    print()
+
+
 def print_statistics(img):
     print("=== Image Statistics ===")
 
@@ -41,16 +69,25 @@ def print_statistics(img):
 def main():
     parser = argparse.ArgumentParser(description="Display image information and metadata")
     parser.add_argument("image_path", help="Path to input image")
+    parser.add_argument("--stats", action="store_true",
+                        help="Decode the image and print per-channel statistics")
 
     args = parser.parse_args()
 
+    # Header probe is enough unless pixel statistics are requested
+    info = probe_image(args.image_path) if not args.stats else None
+    if info is not None:
+        print_header_info(info, args.image_path)
+        return
+
     img = read_image(args.image_path)
     if img is None:
         sys.stderr.write("Error: Could not read image\n")
         sys.exit(1)
 
     print_basic_info(img, args.image_path)
-    print_statistics(img)
+    if args.stats:
+        print_statistics(img)
 
 
 if __name__ == "__main__":
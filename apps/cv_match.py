@@ -2,7 +2,7 @@ import sys
 import cv2
 import numpy as np
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import read_image, write_image, add_encode_option, set_encode_policy
 import os
 
 def keypoints_to_array(kps):
@@ -18,32 +18,92 @@ def matches_to_array(matches):
         for m in matches
     ], dtype=np.float32)
 
-def compute_matches(img1, img2, lowe_ratio=0.75):
-    # Initialize SIFT detector
-    sift = cv2.SIFT_create()
-
-    # Find the keypoints and descriptors with ORB
-    kp1, des1 = sift.detectAndCompute(img1, None)
-    kp2, des2 = sift.detectAndCompute(img2, None)
-
-    if des1 is None or des2 is None:
-        sys.stderr.write("Error: No descriptors found in one or both images.\n")
-        sys.exit(1)
-
-
-    # Create BFMatcher object
-    bf = cv2.BFMatcher(cv2.NORM_L2, crossCheck=False)
+FEATURES = ('sift', 'orb', 'akaze')
+
+# Keypoints kept per image after grid selection (0 = all). SIFT keeps its
+# previous behaviour; the binary detectors are meant for fast previews.
+DEFAULT_MAX_KEYPOINTS = {'sift': 0, 'orb': 2000, 'akaze': 2000}
+
+def create_detector(features):
+    if features == 'orb':
+        # Over-detect, then let the grid selection pick a spatially even subset
+        return cv2.ORB_create(nfeatures=10000)
+    if features == 'akaze':
+        # Part of the main module in OpenCV 4.x, moved out in some 5.x builds
+        if not hasattr(cv2, 'AKAZE_create'):
+            sys.stderr.write("Error: AKAZE is not available in this OpenCV build.\n")
+            sys.exit(1)
+        return cv2.AKAZE_create()
+    return cv2.SIFT_create()
+
+def grid_select(keypoints, shape, max_keypoints, grid=8):
+    """
+    Keep at most max_keypoints, spread evenly over a grid x grid layout:
+    the strongest keypoint of every cell first, then the second strongest,
+    and so on, so textured regions cannot take the whole budget.
+    """
+    if max_keypoints <= 0 or len(keypoints) <= max_keypoints:
+        return keypoints
+    h, w = shape[:2]
+    pts = np.array([kp.pt for kp in keypoints], dtype=np.float32)
+    response = np.array([kp.response for kp in keypoints], dtype=np.float32)
+    cx = np.minimum((pts[:, 0] * grid / w).astype(np.int32), grid - 1)
+    cy = np.minimum((pts[:, 1] * grid / h).astype(np.int32), grid - 1)
+    cell = cy * grid + cx
+
+    # Rank of every keypoint inside its cell, strongest first
+    order = np.lexsort((-response, cell))
+    sorted_cells = cell[order]
+    starts = np.searchsorted(sorted_cells, sorted_cells, side='left')
+    rank = np.empty(len(order), dtype=np.int32)
+    rank[order] = np.arange(len(order)) - starts
+
+    keep = np.lexsort((-response, rank))[:max_keypoints]
+    return [keypoints[i] for i in keep]
+
+def detect_features(img, features='sift', max_keypoints=None):
+    if max_keypoints is None:
+        max_keypoints = DEFAULT_MAX_KEYPOINTS[features]
+    detector = create_detector(features)
+    if max_keypoints <= 0:
+        return detector.detectAndCompute(img, None)
+
+    # Detect, cap uniformly over the image, then describe only what is kept
+    keypoints = detector.detect(img, None)
+    keypoints = grid_select(keypoints, img.shape, max_keypoints)
+    return detector.compute(img, keypoints)
+
+def match_descriptors(des1, des2, lowe_ratio=0.75):
+    # Binary descriptors (ORB, AKAZE) are compared by Hamming distance,
+    # which OpenCV computes with vectorised popcount; float ones by L2
+    norm = cv2.NORM_HAMMING if des1.dtype == np.uint8 else cv2.NORM_L2
+    bf = cv2.BFMatcher(norm, crossCheck=False)
 
     # Match descriptors using KNN algorithm
     matches = bf.knnMatch(des1, des2, k=2)
 
     # Apply ratio test
     good_matches = []
-    for m, n in matches:
+    for pair in matches:
+        if len(pair) < 2:
+            continue
+        m, n = pair
         # If the distance of the best match (m) is significantly smaller than the second best match (n), it's a good match.
         if m.distance < lowe_ratio * n.distance: # A common threshold is 0.75
             good_matches.append(m)
 
+    return good_matches
+
+def compute_matches(img1, img2, lowe_ratio=0.75, features='sift', max_keypoints=None):
+    kp1, des1 = detect_features(img1, features, max_keypoints)
+    kp2, des2 = detect_features(img2, features, max_keypoints)
+
+    if des1 is None or des2 is None:
+        sys.stderr.write("Error: No descriptors found in one or both images.\n")
+        sys.exit(1)
+
+    good_matches = match_descriptors(des1, des2, lowe_ratio)
+
     return kp1, kp2, des1, des2, good_matches
 
 def RANSAC_filter(kp1, kp2, matches, reproj_thresh =5.0):
@@ -59,7 +119,7 @@ def RANSAC_filter(kp1, kp2, matches, reproj_thresh =5.0):
     return matches_mask
 
 def main():
-    parser = argparse.ArgumentParser(description="Match features between two images using SIFT.")
+    parser = argparse.ArgumentParser(description="Match features between two images using SIFT, ORB or AKAZE.")
     parser.add_argument("image1_path", help="Path to the first input image")
     parser.add_argument("image2_path", help="Path to the second input image")
     parser.add_argument("--out_dir", default="cv_match_out", help="Directory to save output files")
@@ -68,8 +128,12 @@ def main():
     parser.add_argument("--max_matches", "-m", type=int, default=0, help="Maximum number of matches to draw (0 = all)")
     parser.add_argument("--lowe_ratio", "-r", type=float, default=0.75, help="Lowe's ratio threshold for filtering matches (default=0.75)")
     parser.add_argument("--reproj_thresh", "-t", type=float, default=5.0, help="RANSAC reprojection threshold in pixels (default=5.0)")
+    parser.add_argument("--features", "-f", choices=FEATURES, default="sift", help="Feature detector/descriptor (default=sift)")
+    parser.add_argument("--max_keypoints", "-k", type=int, default=None, help="Keypoints kept per image, spread over a grid (0 = all; default: 0 for sift, 2000 otherwise)")
 
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
     # Create output directory if it doesn't exist
     os.makedirs(args.out_dir, exist_ok=True)
@@ -82,7 +146,8 @@ def main():
         sys.exit(1)
 
     # Compute matches
-    kp1, kp2, des1, des2, good_matches = compute_matches(img1, img2, lowe_ratio=args.lowe_ratio)
+    kp1, kp2, des1, des2, good_matches = compute_matches(img1, img2, lowe_ratio=args.lowe_ratio,
+                                                         features=args.features, max_keypoints=args.max_keypoints)
 
     # Use RANSAC to filter matches
     matches_mask = RANSAC_filter(kp1, kp2, good_matches, reproj_thresh=args.reproj_thresh)
@@ -3,7 +3,7 @@ import sys
 import cv2
 import numpy as np
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import run_filter, add_encode_option, set_encode_policy
 
 def main():
     parser = argparse.ArgumentParser(description="Apply median filter to an image.")
@@ -14,24 +14,18 @@ def main():
     parser.add_argument("--ksize", "-k", type=int, default=3,
                         help="Kernel size for median filter (must be odd, default: 3)")
     
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
     # Check that kernel size is odd
     if args.ksize % 2 == 0:
         sys.stderr.write("Error: Kernel size must be an odd number.\n")
         sys.exit(1)
 
-    # Read image
-    img = read_image(args.input_path)
-    if img is None:
-        sys.stderr.write("Error: No input image provided.\n")
-        sys.exit(1)
-
-    # Apply median filter
-    filtered = cv2.medianBlur(img, args.ksize)
-
-    # Save or output image
-    write_image(filtered, args.output)
+    # Apply median filter to the image or to every frame of a stream
+    run_filter(args.input_path, args.output,
+               lambda img: cv2.medianBlur(img, args.ksize))
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+import sys
+import os
+import time
+import json
+import argparse
+import cv2
+import numpy as np
+from cv_match import detect_features, match_descriptors, RANSAC_filter
+from cv_utils import read_image, IMAGE_EXTENSIONS
+
+# Finds which images of a set overlap without matching every pair.
+# SIFT descriptors are quantised with a vocabulary tree, each image
+# becomes a tf-idf weighted bag of words, and an inverted file scores only
+# the images that share words with each query. Full matching + RANSAC
+# then runs on the top-k candidates per image, and the verified pairs
+# form a match graph.
+
+BRANCH = 16
+MAX_WORDS = 1 << 20
+
+def nearest_center(des, centers, block=4096):
+    """Index of the closest center per descriptor (squared L2, via BLAS)."""
+    norms = (centers * centers).sum(axis=1)
+    labels = np.empty(len(des), dtype=np.int32)
+    for start in range(0, len(des), block):
+        chunk = des[start:start + block]
+        labels[start:start + block] = np.argmin(norms - 2.0 * chunk @ centers.T, axis=1)
+    return labels
+
+def kmeans(points, k, iterations, rng):
+    """Lloyd's k-means; returns (centers, labels)."""
+    centers = points[rng.choice(len(points), k, replace=False)].copy()
+    for _ in range(iterations):
+        labels = nearest_center(points, centers)
+        sums = np.zeros_like(centers)
+        np.add.at(sums, labels, points)
+        counts = np.bincount(labels, minlength=k)
+        used = counts > 0
+        centers[used] = sums[used] / counts[used, None]
+    return centers, nearest_center(points, centers)
+
+class VocabularyTree:
+    """
+    Hierarchical k-means vocabulary (Nister & Stewenius): every node splits
+    its descriptors into BRANCH clusters and the leaves are the visual
+    words. Training and quantisation cost grow with the depth, not with
+    the number of words, so the vocabulary can grow with the collection.
+    """
+    def __init__(self, descriptors, words, sample=500000, iterations=8, seed=0):
+        rng = np.random.default_rng(seed)
+        pool = np.vstack(descriptors).astype(np.float32)
+        if len(pool) > sample:
+            pool = pool[rng.choice(len(pool), sample, replace=False)]
+        self.depth = max(1, int(np.ceil(np.log(words) / np.log(BRANCH))))
+        self.centers = []    # node -> child centers, None for leaves
+        self.children = []   # node -> child node ids
+        self.word = []       # node -> word id, -1 for inner nodes
+        self.size = 0
+        self._build(pool, self.depth, iterations, rng)
+        self.word = np.array(self.word, dtype=np.int32)
+
+    def _build(self, points, depth, iterations, rng):
+        node = len(self.word)
+        self.centers.append(None)
+        self.children.append(None)
+        self.word.append(-1)
+        if depth == 0 or len(points) < 2 * BRANCH:
+            self.word[node] = self.size
+            self.size += 1
+            return node
+        centers, labels = kmeans(points, BRANCH, iterations, rng)
+        self.centers[node] = centers
+        self.children[node] = np.array(
+            [self._build(points[labels == c], depth - 1, iterations, rng) for c in range(BRANCH)])
+        return node
+
+    def quantize(self, des):
+        """Word id per descriptor; descriptors are routed level by level, grouped by node."""
+        des = des.astype(np.float32)
+        node = np.zeros(len(des), dtype=np.int64)
+        for _ in range(self.depth):
+            inner = np.nonzero(self.word[node] < 0)[0]
+            if len(inner) == 0:
+                break
+            inner = inner[np.argsort(node[inner], kind='stable')]
+            groups, starts = np.unique(node[inner], return_index=True)
+            for g, sel in zip(groups, np.split(inner, starts[1:])):
+                node[sel] = self.children[g][nearest_center(des[sel], self.centers[g])]
+        return self.word[node]
+
+def quantize_all(tree, descriptors, block=200000):
+    """Quantises images in batches, so each tree node is visited once per batch."""
+    words, batch = [], []
+    for i, des in enumerate(descriptors):
+        batch.append(des)
+        if sum(len(d) for d in batch) >= block or i == len(descriptors) - 1:
+            labels = tree.quantize(np.vstack(batch)) if any(len(d) for d in batch) else np.zeros(0, np.int32)
+            words.extend(np.split(labels, np.cumsum([len(d) for d in batch])[:-1]))
+            batch = []
+    return words
+
+def default_vocab_size(n):
+    """Grow the vocabulary with the collection so words stay discriminative."""
+    return int(min(MAX_WORDS, max(4096, 64 * n)))
+
+def build_inverted_file(words, vocab_size):
+    """
+    Returns per-image sparse tf-idf vectors (word ids, weights) and the
+    inverted file in CSR form: (offsets, images, weights), where the
+    postings of word w are at offsets[w]:offsets[w + 1].
+    """
+    n = len(words)
+    bags = [np.unique(w, return_counts=True) for w in words]
+    df = np.bincount(np.concatenate([ids for ids, _ in bags] + [np.zeros(0, np.int64)]),
+                     minlength=vocab_size)
+    idf = np.log(n / np.maximum(df, 1)).astype(np.float32)
+
+    vectors = []
+    for ids, counts in bags:
+        v = (counts / max(counts.sum(), 1)).astype(np.float32) * idf[ids]
+        norm = np.linalg.norm(v)
+        if norm > 0:
+            v /= norm
+        keep = v > 0
+        vectors.append((ids[keep], v[keep]))
+
+    word_ids = np.concatenate([ids for ids, _ in vectors] + [np.zeros(0, np.int64)])
+    images = np.concatenate([np.full(len(ids), i, np.int32) for i, (ids, _) in enumerate(vectors)]
+                            + [np.zeros(0, np.int32)])
+    weights = np.concatenate([v for _, v in vectors] + [np.zeros(0, np.float32)])
+    order = np.argsort(word_ids, kind='stable')
+    offsets = np.zeros(vocab_size + 1, dtype=np.int64)
+    offsets[1:] = np.cumsum(np.bincount(word_ids, minlength=vocab_size))
+    return vectors, (offsets, images[order], weights[order])
+
+def rank_candidates(vectors, postings, top_k):
+    """
+    Cosine scores through the inverted file; returns {(i, j): score} with i < j.
+    Only the postings of a query's words are visited and summed sparsely, so
+    the cost follows the images that share words rather than the collection.
+    """
+    offsets, post_images, post_weights = postings
+    candidates = {}
+    for i, (ids, weights) in enumerate(vectors):
+        starts = offsets[ids]
+        lengths = offsets[ids + 1] - starts
+        total = int(lengths.sum())
+        if total == 0:
+            continue
+        # Gather every posting of the query's words in one indexing step
+        first = np.cumsum(lengths) - lengths
+        idx = np.arange(total) + np.repeat(starts - first, lengths)
+        others, slot = np.unique(post_images[idx], return_inverse=True)
+        scores = np.bincount(slot, weights=post_weights[idx] * np.repeat(weights, lengths))
+        scores[others == i] = -1.0
+        k = min(top_k, len(others))
+        best = np.argpartition(-scores, k - 1)[:k] if k < len(others) else np.arange(len(others))
+        for b in best[np.argsort(-scores[best])]:
+            if scores[b] <= 0:
+                break
+            j = int(others[b])
+            key = (min(i, j), max(i, j))
+            candidates[key] = max(candidates.get(key, 0.0), float(scores[b]))
+    return candidates
+
+def stitch_order(n, edges):
+    """
+    Prim's order over the maximum spanning tree (weighted by inliers),
+    starting from the best connected image, so every image added overlaps
+    one that is already in the panorama. Only that image's connected
+    component is returned.
+    """
+    adjacency = [[] for _ in range(n)]
+    for e in edges:
+        adjacency[e["a"]].append((e["inliers"], e["b"]))
+        adjacency[e["b"]].append((e["inliers"], e["a"]))
+    if not edges:
+        return []
+
+    start = max(range(n), key=lambda i: sum(w for w, _ in adjacency[i]))
+    order, seen, frontier = [start], {start}, list(adjacency[start])
+    while frontier:
+        frontier.sort()
+        _, nxt = frontier.pop()
+        if nxt in seen:
+            continue
+        seen.add(nxt)
+        order.append(nxt)
+        frontier.extend(adjacency[nxt])
+    return order
+
+def main():
+    parser = argparse.ArgumentParser(description="Find overlapping image pairs with a visual-vocabulary index.")
+    parser.add_argument("directory", help="Directory of images to pair")
+    parser.add_argument("--out_dir", default=None,
+                        help="Directory to save match_graph.json (default: cv_pairs_out, not written with --order)")
+    parser.add_argument("--top_k", "-k", type=int, default=3, help="Candidates verified per image (default=3)")
+    parser.add_argument("--vocab", type=int, default=None,
+                        help="Visual vocabulary size (default: 64 per image, at least 4096)")
+    parser.add_argument("--min_inliers", type=int, default=20, help="RANSAC inliers needed to keep an edge (default=20)")
+    parser.add_argument("--lowe_ratio", "-r", type=float, default=0.75, help="Lowe's ratio for matching")
+    parser.add_argument("--reproj_thresh", "-t", type=float, default=5.0, help="RANSAC reprojection threshold")
+    parser.add_argument("--order", action="store_true", help="Print only the stitching order, one path per line")
+    args = parser.parse_args()
+
+    paths = sorted(
+        os.path.join(args.directory, f) for f in os.listdir(args.directory)
+        if f.lower().endswith(IMAGE_EXTENSIONS)
+    )
+    if len(paths) < 2:
+        sys.stderr.write("Error: Need at least 2 images.\n")
+        sys.exit(1)
+
+    t0 = time.perf_counter()
+    keypoints, descriptors = [], []
+    for path in paths:
+        img = read_image(path)
+        if img is None:
+            sys.stderr.write(f"Error: Could not read {path}\n")
+            sys.exit(1)
+        kp, des = detect_features(img)
+        if des is None:
+            des = np.zeros((0, 128), np.float32)
+        keypoints.append(kp)
+        descriptors.append(des)
+
+    t1 = time.perf_counter()
+    tree = VocabularyTree([d for d in descriptors if len(d)], args.vocab or default_vocab_size(len(paths)))
+    words = quantize_all(tree, descriptors)
+    vectors, postings = build_inverted_file(words, tree.size)
+    candidates = rank_candidates(vectors, postings, args.top_k)
+
+    # Full matching + RANSAC only on the retrieved candidates
+    t2 = time.perf_counter()
+    edges = []
+    for (i, j), score in sorted(candidates.items()):
+        if len(descriptors[i]) < 2 or len(descriptors[j]) < 2:
+            continue
+        good = match_descriptors(descriptors[i], descriptors[j], args.lowe_ratio)
+        mask = RANSAC_filter(keypoints[i], keypoints[j], good, args.reproj_thresh)
+        inliers = int(sum(mask)) if mask is not None else 0
+        if inliers >= args.min_inliers:
+            edges.append(dict(a=i, b=j, score=round(score, 4), matches=len(good), inliers=inliers))
+    t3 = time.perf_counter()
+
+    order = stitch_order(len(paths), edges)
+    in_order = set(order)
+    graph = dict(
+        images=paths,
+        edges=edges,
+        order=[paths[i] for i in order],
+        unconnected=[p for i, p in enumerate(paths) if i not in in_order],
+    )
+
+    # --order is for scripts; it only leaves a file behind when asked to
+    graph_path = None
+    if args.out_dir or not args.order:
+        out_dir = args.out_dir or "cv_pairs_out"
+        os.makedirs(out_dir, exist_ok=True)
+        graph_path = os.path.join(out_dir, "match_graph.json")
+        with open(graph_path, "w") as f:
+            json.dump(graph, f, indent=2)
+
+    n = len(paths)
+    sys.stderr.write(f"Features: {t1 - t0:.2f}s, retrieval: {t2 - t1:.2f}s, "
+                     f"verification: {t3 - t2:.2f}s\n")
+    sys.stderr.write(f"Verified {len(candidates)} candidate pairs instead of {n * (n - 1) // 2}; "
+                     f"{len(edges)} overlapping\n")
+    if graph["unconnected"]:
+        sys.stderr.write(f"Not connected to the main panorama: {', '.join(graph['unconnected'])}\n")
+
+    if args.order:
+        for path in graph["order"]:
+            print(path)
+        return
+
+    for e in edges:
+        print(f"{paths[e['a']]} <-> {paths[e['b']]}: score {e['score']:.3f}, "
+              f"{e['matches']} matches, {e['inliers']} inliers")
+    print(f"Match graph saved to {graph_path}")
+
+if __name__ == "__main__":
+    main()
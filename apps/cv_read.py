@@ -1,19 +1,26 @@
 #!/usr/bin/env python3
 import sys
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import read_image, write_image, is_stream_source, run_filter, add_encode_option, set_encode_policy
 
 def main():
     parser = argparse.ArgumentParser(description="Read an image and output it to the pipeline.")
     parser.add_argument("input_path", nargs='?', help="Path to the input image")
     parser.add_argument("--output", "-o", help="Path to save the output image (optional)")
     
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
     if not args.input_path:
         sys.stderr.write("Error: Input path is required for cv-read.\n")
         sys.exit(1)
 
+    # Videos and directories are emitted as a frame stream
+    if is_stream_source(args.input_path):
+        run_filter(args.input_path, args.output, lambda frame: frame)
+        return
+
     img = read_image(args.input_path)
     if img is None:
         sys.stderr.write(f"Error: Could not read image from {args.input_path}\n")
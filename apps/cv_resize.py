@@ -2,10 +2,10 @@
 import sys
 import cv2
 import argparse
-from cv_utils import read_image, write_image
+from cv_utils import run_filter, add_encode_option, set_encode_policy
 
 def main():
-    parser = argparse.ArgumentParser(description="Resize an image using bilinear interpolation.")
+    parser = argparse.ArgumentParser(description="Resize an image (area resampling to shrink, bilinear to enlarge).")
     parser.add_argument("input_path", nargs='?', help="Path to input image (optional, defaults to stdin)")
     parser.add_argument("--output", "-o", help="Path to save output (optional, defaults to stdout)")
     
@@ -20,47 +20,50 @@ def main():
     parser.add_argument("--no-aspect-preservation", action="store_true", 
                        help="Do not preserve aspect ratio when only one dimension/scale is provided")
     
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
-    # Read image
-    img = read_image(args.input_path)
-    if img is None:
-        sys.stderr.write("Error: No input image provided or could not read image.\n")
-        sys.exit(1)
+    def target_size(w, h):
+        """Output size for a source of w x h."""
+        new_w, new_h = w, h
 
-    # Get original dimensions
-    h, w = img.shape[:2]
-    new_w, new_h = w, h
-
-    # Determine resize mode
-    if args.width is not None or args.height is not None:
-        new_w = args.width if args.width is not None else w
-        new_h = args.height if args.height is not None else h
-        
-        if not args.no_aspect_preservation:
-            if args.width is not None and args.height is None:
-                new_h = int(h * (args.width / w))
-            elif args.height is not None and args.width is None:
-                new_w = int(w * (args.height / h))
-            
-        resized_img = cv2.resize(img, (new_w, new_h), interpolation=cv2.INTER_LINEAR)
-        
-    elif args.scale_x is not None or args.scale_y is not None:
-        sx = args.scale_x if args.scale_x is not None else 1.0
-        sy = args.scale_y if args.scale_y is not None else 1.0
+        # Determine resize mode
+        if args.width is not None or args.height is not None:
+            new_w = args.width if args.width is not None else w
+            new_h = args.height if args.height is not None else h
         
-        if not args.no_aspect_preservation:
-            if args.scale_x is not None and args.scale_y is None:
-                sy = sx
-            elif args.scale_y is not None and args.scale_x is None:
-                sx = sy
+            if not args.no_aspect_preservation:
+                if args.width is not None and args.height is None:
+                    new_h = int(h * (args.width / w))
+                elif args.height is not None and args.width is None:
+                    new_w = int(w * (args.height / h))
         
-        resized_img = cv2.resize(img, None, fx=sx, fy=sy, interpolation=cv2.INTER_LINEAR)
+        elif args.scale_x is not None or args.scale_y is not None:
+            sx = args.scale_x if args.scale_x is not None else 1.0
+            sy = args.scale_y if args.scale_y is not None else 1.0
         
-    else:
-        resized_img = img
+            if not args.no_aspect_preservation:
+                if args.scale_x is not None and args.scale_y is None:
+                    sy = sx
+                elif args.scale_y is not None and args.scale_x is None:
+                    sx = sy
+
+            new_w, new_h = round(w * sx), round(h * sy)
+
+        return max(1, new_w), max(1, new_h)
+
+    def resize(img, size):
+        # img may already be decoded at 1/2, 1/4 or 1/8 scale; size is the final one
+        h, w = img.shape[:2]
+        if (w, h) == size:
+            return img
+        # Area averaging does not alias when shrinking; bilinear for enlarging
+        shrink = size[0] <= w and size[1] <= h
+        return cv2.resize(img, size, interpolation=cv2.INTER_AREA if shrink else cv2.INTER_LINEAR)
 
-    write_image(resized_img, args.output)
+    # Dimensions are recomputed per frame, so streams of mixed sizes work too
+    run_filter(args.input_path, args.output, resize, target_size)
 
 if __name__ == "__main__":
     main()
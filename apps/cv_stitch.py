@@ -3,18 +3,22 @@ import cv2
 import numpy as np
 import argparse
 import os
-from cv_match import compute_matches, RANSAC_filter, keypoints_to_array, matches_to_array
-from cv_utils import read_image, write_image
+from cv_match import compute_matches, RANSAC_filter, keypoints_to_array, matches_to_array, FEATURES
+from cv_utils import read_image, write_image, add_encode_option, set_encode_policy
 
 def main():
-    parser = argparse.ArgumentParser(description="Stitch two images into a panorama using SIFT matches.")
+    parser = argparse.ArgumentParser(description="Stitch two images into a panorama using SIFT, ORB or AKAZE matches.")
     parser.add_argument("image1_path", help="Path to the first input image")
     parser.add_argument("image2_path", help="Path to the second input image")
     parser.add_argument("--out_dir", default="cv_stitch_out", help="Directory to save output files")
     parser.add_argument("--out_image", default="panorama.png", help="Output panorama filename")
     parser.add_argument("--lowe_ratio", "-r", type=float, default=0.75, help="Lowe's ratio for matching")
     parser.add_argument("--reproj_thresh", "-t", type=float, default=5.0, help="RANSAC reprojection threshold")
+    parser.add_argument("--features", "-f", choices=FEATURES, default="sift", help="Feature detector/descriptor (default=sift)")
+    parser.add_argument("--max_keypoints", "-k", type=int, default=None, help="Keypoints kept per image, spread over a grid (0 = all; default: 0 for sift, 2000 otherwise)")
+    add_encode_option(parser)
     args = parser.parse_args()
+    set_encode_policy(args.encode)
 
     # Create output directory if it doesn't exist
     os.makedirs(args.out_dir, exist_ok=True)
@@ -28,7 +32,8 @@ def main():
         sys.exit(1)
 
     # Compute matches
-    kp1, kp2, des1, des2, good_matches = compute_matches(img1, img2, lowe_ratio=args.lowe_ratio)
+    kp1, kp2, des1, des2, good_matches = compute_matches(img1, img2, lowe_ratio=args.lowe_ratio,
+                                                         features=args.features, max_keypoints=args.max_keypoints)
 
     # Use RANSAC to filter matches
     matches_mask = RANSAC_filter(kp1, kp2, good_matches, reproj_thresh=args.reproj_thresh)
@@ -2,6 +2,373 @@ import sys
 import cv2
 import numpy as np
 import os
+import hashlib
+import stat
+import struct
+import fcntl
+import queue
+import atexit
+import threading
+from img_probe import probe_image
+
+# Thread budget handed out by the shell when several stages run at once
+THREAD_BUDGET = int(os.environ.get("VISIONOS_THREADS", 0))
+if THREAD_BUDGET > 0:
+    cv2.setNumThreads(THREAD_BUDGET)
+
+# Shared decoded-image cache. Decoded pixels are stored as .npy files in a
+# tmpfs directory so that later commands can map them instead of decoding
+# the same file again. The C shell reports on it with `cache-stats`.
+# Pixels of private images must not leak, so the cache is per user: a 0700
+# directory we own, with 0600 entries.
+CACHE_DIR = os.environ.get("VISIONOS_CACHE_DIR", f"/dev/shm/visionos-cache-{os.getuid()}")
+CACHE_BUDGET = int(os.environ.get("VISIONOS_CACHE_BYTES", 512 * 1024 * 1024))
+CACHE_ENABLED = os.environ.get("VISIONOS_CACHE", "1") != "0"
+
+_cache_dir_ok = None
+
+def _cache_dir_usable():
+    """Creates the cache directory; False if it is not ours alone to write."""
+    global _cache_dir_ok
+    if _cache_dir_ok is None:
+        try:
+            os.makedirs(CACHE_DIR, mode=0o700, exist_ok=True)
+            st = os.lstat(CACHE_DIR)
+            _cache_dir_ok = (stat.S_ISDIR(st.st_mode) and st.st_uid == os.getuid()
+                             and not st.st_mode & 0o022)
+        except OSError:
+            _cache_dir_ok = False
+        if not _cache_dir_ok:
+            sys.stderr.write(f"Warning: {CACHE_DIR} is not a directory owned by you alone; "
+                             "image cache disabled\n")
+    return _cache_dir_ok
+
+def _cache_key(path, st, flags):
+    ident = f"{os.path.abspath(path)}:{st.st_dev}:{st.st_ino}:{st.st_mtime_ns}:{st.st_size}:{flags}"
+    return hashlib.sha1(ident.encode()).hexdigest()
+
+# Counters shared by every command: hits, misses and an estimate of the
+# bytes stored. Fixed size and updated in place under flock.
+CACHE_STATS = struct.Struct("<qqq")
+
+def _cache_update(hits=0, misses=0, added=0, resident=None):
+    """Adds to the counters (or sets the byte estimate); returns the estimate."""
+    try:
+        fd = os.open(os.path.join(CACHE_DIR, "stats"), os.O_RDWR | os.O_CREAT, 0o600)
+    except OSError:
+        return 0
+    try:
+        fcntl.flock(fd, fcntl.LOCK_EX)
+        data = os.pread(fd, CACHE_STATS.size, 0)
+        h, m, size = CACHE_STATS.unpack(data) if len(data) == CACHE_STATS.size else (0, 0, 0)
+        size = resident if resident is not None else size + added
+        os.pwrite(fd, CACHE_STATS.pack(h + hits, m + misses, size), 0)
+        return size
+    except OSError:
+        return 0
+    finally:
+        os.close(fd)
+
+def _cache_evict():
+    """Remove least recently used entries until the cache fits its budget; returns the bytes left."""
+    entries = []
+    total = 0
+    with os.scandir(CACHE_DIR) as it:
+        for entry in it:
+            if not entry.name.endswith(".npy"):
+                continue
+            try:
+                st = entry.stat()
+            except OSError:
+                continue
+            entries.append((st.st_mtime_ns, st.st_size, entry.path))
+            total += st.st_size
+    if total <= CACHE_BUDGET:
+        return total
+    entries.sort()
+    for _, size, path in entries:
+        try:
+            os.unlink(path)
+        except OSError:
+            continue
+        total -= size
+        if total <= CACHE_BUDGET:
+            break
+    return total
+
+def cached_imread(path, flags=cv2.IMREAD_COLOR):
+    """
+    cv2.imread() backed by the shared decoded-image cache.
+    Hits are memory-mapped copy-on-write, so nothing is copied until written.
+    """
+    if not CACHE_ENABLED:
+        return cv2.imread(path, flags)
+
+    try:
+        st = os.stat(path)
+    except OSError:
+        return cv2.imread(path, flags)
+    if not _cache_dir_usable():
+        return cv2.imread(path, flags)
+
+    entry = os.path.join(CACHE_DIR, _cache_key(path, st, flags) + ".npy")
+    try:
+        img = np.load(entry, mmap_mode='c')
+        os.utime(entry)  # LRU clock
+        _cache_update(hits=1)
+        return img
+    except (OSError, ValueError):
+        pass
+
+    _cache_update(misses=1)
+    img = cv2.imread(path, flags)
+    if img is None or img.nbytes > CACHE_BUDGET:
+        return img
+
+    # Write to a private name first so readers never map a partial file
+    tmp = f"{entry}.{os.getpid()}.tmp"
+    try:
+        with os.fdopen(os.open(tmp, os.O_WRONLY | os.O_CREAT | os.O_EXCL, 0o600), "wb") as f:
+            np.save(f, img)
+        os.replace(tmp, entry)
+        # Scan the directory only once the estimate says we are over budget
+        if _cache_update(added=os.path.getsize(entry)) > CACHE_BUDGET:
+            _cache_update(resident=_cache_evict())
+    except OSError:
+        try:
+            os.unlink(tmp)
+        except OSError:
+            pass
+    return img
+
+# Framed stream format used between cv apps for image sequences and video.
+# Every frame is a fixed header followed by the raw pixels, so stages skip
+# encoding/decoding and can reuse their buffers from frame to frame.
+FRAME_MAGIC = b"VOSF"
+FRAME_HEADER = struct.Struct("<4sIIIB3x")  # magic, height, width, channels, dtype
+FRAME_DTYPES = [np.uint8, np.uint16, np.float32]
+IMAGE_EXTENSIONS = ('.jpg', '.jpeg', '.png', '.bmp', '.webp', '.tif', '.tiff')
+VIDEO_EXTENSIONS = ('.mp4', '.avi', '.mov', '.mkv')
+STREAM_FPS = float(os.environ.get("VISIONOS_FPS", 30))
+
+def is_video_path(path):
+    return path is not None and path.lower().endswith(VIDEO_EXTENSIONS)
+
+def stdin_is_framed():
+    try:
+        return sys.stdin.buffer.peek(len(FRAME_MAGIC))[:len(FRAME_MAGIC)] == FRAME_MAGIC
+    except (OSError, ValueError):
+        return False
+
+def is_stream_source(source):
+    """True when the input is a frame sequence rather than a single image."""
+    if source is None:
+        return stdin_is_framed()
+    return os.path.isdir(source) or is_video_path(source)
+
+def _read_exact(stream, view):
+    got = 0
+    while got < len(view):
+        n = stream.readinto(view[got:])
+        if not n:
+            return False
+        got += n
+    return True
+
+def read_frames_stdin():
+    """
+    Yields frames from a framed stream on stdin.
+    The same buffer is reused while the frame shape stays constant, so a
+    consumer must copy a frame it wants to keep past the next iteration.
+    """
+    stream = sys.stdin.buffer
+    header = bytearray(FRAME_HEADER.size)
+    frame = None
+    while _read_exact(stream, memoryview(header)):
+        magic, h, w, c, dtype = FRAME_HEADER.unpack(header)
+        if magic != FRAME_MAGIC or dtype >= len(FRAME_DTYPES):
+            sys.stderr.write("Error: Corrupt frame stream on stdin\n")
+            return
+        shape = (h, w) if c == 1 else (h, w, c)
+        if frame is None or frame.shape != shape or frame.dtype != FRAME_DTYPES[dtype]:
+            frame = np.empty(shape, FRAME_DTYPES[dtype])
+        if not _read_exact(stream, memoryview(frame).cast('B')):
+            sys.stderr.write("Error: Truncated frame on stdin\n")
+            return
+        yield frame
+
+def read_frames(source=None):
+    """Yields frames from stdin, a video file, a directory of images or one image."""
+    if source is None:
+        if stdin_is_framed():
+            yield from read_frames_stdin()
+        else:
+            img = read_image(None)
+            if img is not None:
+                yield img
+    elif is_video_path(source):
+        cap = cv2.VideoCapture(source)
+        frame = None
+        while True:
+            ok, frame = cap.read(frame)
+            if not ok:
+                break
+            yield frame
+        cap.release()
+    elif os.path.isdir(source):
+        # Sequences are read once; caching them would only evict useful entries
+        for name in sorted(os.listdir(source)):
+            if name.lower().endswith(IMAGE_EXTENSIONS):
+                img = cv2.imread(os.path.join(source, name))
+                if img is not None:
+                    yield img
+    else:
+        img = read_image(source)
+        if img is not None:
+            yield img
+
+def write_frame(frame, stream):
+    frame = np.ascontiguousarray(frame)
+    channels = 1 if frame.ndim == 2 else frame.shape[2]
+    dtype = FRAME_DTYPES.index(frame.dtype.type)
+    stream.write(FRAME_HEADER.pack(FRAME_MAGIC, frame.shape[0], frame.shape[1], channels, dtype))
+    stream.write(memoryview(frame).cast('B'))
+
+class FrameWriter:
+    """
+    Writes a frame sequence to stdout (framed stream), a video file,
+    or numbered images. An image path receives the first frame as-is and
+    later frames as <stem>_000001<ext>, ... unless it holds a %d pattern.
+    Only a pipe gets the framed stream; any other stdout (a redirect to a
+    file, a terminal) takes a single frame as a PNG.
+    """
+    def __init__(self, dest=None):
+        self.dest = dest
+        self.index = 0
+        self.video = None
+        self.pipe = dest is None and _stdout_is_pipe()
+        self.held = None
+
+    def write(self, frame):
+        if frame is None:
+            return
+        if self.pipe:
+            write_frame(frame, sys.stdout.buffer)
+        elif self.dest is None:
+            if self.held is not None:
+                sys.stderr.write("Error: Several frames cannot be written to a file through stdout; "
+                                 "use -o with a directory, video or %d pattern.\n")
+                sys.exit(1)
+            # Written on close, once we know it is the only one
+            self.held = frame.copy()
+        elif is_video_path(self.dest):
+            if self.video is None:
+                h, w = frame.shape[:2]
+                fourcc = cv2.VideoWriter_fourcc(*('mp4v' if self.dest.lower().endswith('.mp4') else 'MJPG'))
+                self.video = cv2.VideoWriter(self.dest, fourcc, STREAM_FPS, (w, h), frame.ndim == 3)
+            self.video.write(frame)
+        else:
+            write_image(frame, self._frame_path())
+        self.index += 1
+
+    def _frame_path(self):
+        if '%' in self.dest:
+            return self.dest % self.index
+        if not self.dest.lower().endswith(IMAGE_EXTENSIONS + ('.npy',)):
+            os.makedirs(self.dest, exist_ok=True)
+            return os.path.join(self.dest, f"frame_{self.index:06d}.png")
+        if self.index == 0:
+            return self.dest
+        stem, ext = os.path.splitext(self.dest)
+        return f"{stem}_{self.index:06d}{ext}"
+
+    def close(self):
+        if self.video is not None:
+            self.video.release()
+        elif self.held is not None:
+            write_image(self.held)
+        elif self.dest is None:
+            sys.stdout.buffer.flush()
+
+def run_filter(source, dest, process, target_size=None):
+    """
+    Applies process(img) -> img to one image, or to every frame when the
+    input is a stream, a video or a directory. Exits with an error when
+    nothing could be read.
+
+    Resizing filters pass target_size(w, h) -> (w, h) and are called as
+    process(img, size), with size computed from the full source dimensions.
+    Image files are then decoded at a reduced scale when that still covers
+    size (see read_scaled).
+    """
+    if not is_stream_source(source):
+        if target_size is None:
+            img = read_image(source)
+        elif source and os.path.isfile(source):
+            img, size = read_scaled(source, target_size)
+        else:
+            img = read_image(source)
+            size = target_size(img.shape[1], img.shape[0]) if img is not None else None
+        if img is None:
+            sys.stderr.write("Error: No input image provided.\n")
+            sys.exit(1)
+        write_image(process(img) if target_size is None else process(img, size), dest)
+        return
+
+    writer = FrameWriter(dest)
+    if target_size is None:
+        frames = ((frame, None) for frame in read_frames(source))
+    else:
+        frames = _scaled_frames(source, target_size)
+    for frame, size in frames:
+        out = process(frame) if target_size is None else process(frame, size)
+        if out is frame and dest is not None and not is_video_path(dest):
+            # Input buffers are reused; snapshot before handing to write-behind
+            out = out.copy()
+        writer.write(out)
+    writer.close()
+    if writer.index == 0:
+        sys.stderr.write("Error: No frames read from input.\n")
+        sys.exit(1)
+
+# JPEG decoders can scale in the DCT domain, producing 1/2, 1/4 or 1/8 of
+# the pixels for a fraction of the work of a full decode
+REDUCED_COLOR = {2: cv2.IMREAD_REDUCED_COLOR_2, 4: cv2.IMREAD_REDUCED_COLOR_4, 8: cv2.IMREAD_REDUCED_COLOR_8}
+
+def read_scaled(path, target_size, cache=True):
+    """
+    Reads an image file that will be resized to target_size(w, h), computed
+    from its full dimensions. A JPEG is decoded at the smallest DCT scale
+    that is still at least that size, so only the final step is resampled.
+    cache=False skips the decoded-image cache (for sequences).
+    Returns (img, size); img is None if the file could not be read.
+    """
+    imread = cached_imread if cache else cv2.imread
+    info = probe_image(path)
+    if info is None or info['format'] != 'JPEG':
+        img = read_image(path) if cache else imread(path)
+        return img, (target_size(img.shape[1], img.shape[0]) if img is not None else None)
+
+    w, h = info['width'], info['height']
+    if info['orientation'] >= 5:
+        w, h = h, w  # imread returns it rotated upright
+    size = target_size(w, h)
+    for factor in (8, 4, 2):
+        if w // factor >= size[0] and h // factor >= size[1]:
+            return imread(path, REDUCED_COLOR[factor]), size
+    return imread(path), size
+
+def _scaled_frames(source, target_size):
+    """read_frames() for resizing filters: yields (frame, output size)."""
+    if source is not None and os.path.isdir(source):
+        for name in sorted(os.listdir(source)):
+            if name.lower().endswith(IMAGE_EXTENSIONS):
+                img, size = read_scaled(os.path.join(source, name), target_size, cache=False)
+                if img is not None:
+                    yield img, size
+        return
+    for frame in read_frames(source):
+        yield frame, target_size(frame.shape[1], frame.shape[0])
 
 def read_image(source=None):
     """
@@ -11,9 +378,13 @@ def read_image(source=None):
     """
     if source and os.path.exists(source):
         # Read from file
-        return cv2.imread(source)
+        if source.lower().endswith('.npy'):
+            return np.load(source, mmap_mode='c')
+        return cached_imread(source)
     else:
         # Read from stdin
+        if stdin_is_framed():
+            return next(read_frames_stdin(), None)
         try:
             # Read binary data from stdin
             file_bytes = np.frombuffer(sys.stdin.buffer.read(), np.uint8)
@@ -24,19 +395,132 @@ def read_image(source=None):
             sys.stderr.write(f"Error reading from stdin: {e}\n")
             return None
 
+# Output encoding policy: --encode on the command line, else VISIONOS_ENCODE.
+# fast     - cheapest codec settings; stdout gets raw frames instead of PNG
+# balanced - OpenCV defaults
+# small    - maximum compression
+ENCODE_POLICIES = ('fast', 'balanced', 'small')
+_encode_policy = os.environ.get("VISIONOS_ENCODE", "balanced")
+if _encode_policy not in ENCODE_POLICIES:
+    _encode_policy = "balanced"
+WRITE_BEHIND = os.environ.get("VISIONOS_WRITE_BEHIND", "1") != "0"
+
+ENCODE_PARAMS = {
+    'fast': {
+        '.png': [cv2.IMWRITE_PNG_COMPRESSION, 1, cv2.IMWRITE_PNG_STRATEGY, cv2.IMWRITE_PNG_STRATEGY_RLE],
+        '.jpg': [cv2.IMWRITE_JPEG_QUALITY, 90],
+        '.webp': [cv2.IMWRITE_WEBP_QUALITY, 75],
+    },
+    'balanced': {},
+    'small': {
+        '.png': [cv2.IMWRITE_PNG_COMPRESSION, 9],
+        '.jpg': [cv2.IMWRITE_JPEG_QUALITY, 95, cv2.IMWRITE_JPEG_OPTIMIZE, 1, cv2.IMWRITE_JPEG_PROGRESSIVE, 1],
+        '.webp': [cv2.IMWRITE_WEBP_QUALITY, 90],
+    },
+}
+
+def add_encode_option(parser):
+    parser.add_argument("--encode", choices=ENCODE_POLICIES,
+                        help="Output encoding: fast, balanced or small (default: $VISIONOS_ENCODE or balanced)")
+
+def set_encode_policy(policy):
+    global _encode_policy
+    if policy:
+        _encode_policy = policy
+
+def encode_params(ext):
+    ext = '.jpg' if ext.lower() == '.jpeg' else ext.lower()
+    return ENCODE_PARAMS[_encode_policy].get(ext, [])
+
+class _WriteBehind:
+    """
+    Single background thread that encodes and writes outputs in submission
+    order, so the caller can move on to the next frame or exit. The queue is
+    bounded to keep memory in check; pending writes are drained at exit,
+    and a failed write makes the process exit nonzero.
+    """
+    def __init__(self):
+        self.queue = queue.Queue(maxsize=4)
+        self.thread = None
+        self.failed = False
+
+    def _call(self, fn, args):
+        try:
+            fn(*args)
+        except Exception as e:
+            sys.stderr.write(f"Error writing output: {e}\n")
+            self.failed = True
+
+    def submit(self, fn, *args):
+        if not WRITE_BEHIND:
+            self._call(fn, args)
+            return
+        if self.thread is None:
+            self.thread = threading.Thread(target=self._run, daemon=True)
+            self.thread.start()
+        self.queue.put((fn, args))
+
+    def _run(self):
+        while True:
+            item = self.queue.get()
+            if item is None:
+                break
+            self._call(*item)
+
+    def drain(self):
+        if self.thread is not None:
+            self.queue.put(None)
+            self.thread.join()
+            self.thread = None
+
+    def drain_at_exit(self):
+        self.drain()
+        if self.failed:
+            # The exit status is already set by now; only _exit can change it
+            sys.stdout.flush()
+            sys.stderr.flush()
+            os._exit(1)
+
+_writer = _WriteBehind()
+atexit.register(_writer.drain_at_exit)
+
+def _write_file(image, dest):
+    if dest.lower().endswith('.npy'):
+        # Fast lossless intermediate: raw pixels, memory-mapped on read
+        np.save(dest, image)
+    elif not cv2.imwrite(dest, image, encode_params(os.path.splitext(dest)[1])):
+        raise OSError(f"Could not write {dest}")
+
+def _stdout_is_pipe():
+    try:
+        return stat.S_ISFIFO(os.fstat(sys.stdout.fileno()).st_mode)
+    except (OSError, ValueError):
+        return False
+
+def _write_stdout(image):
+    if _encode_policy == 'fast' and _stdout_is_pipe():
+        # Raw frame for the next stage; every cv app reads it back without
+        # decoding. Redirected to a file, stdout still gets a real PNG.
+        write_frame(image, sys.stdout.buffer)
+    else:
+        success, encoded_image = cv2.imencode('.png', image, encode_params('.png'))
+        if not success:
+            raise OSError("Could not encode PNG for stdout")
+        sys.stdout.buffer.write(encoded_image.tobytes())
+    sys.stdout.buffer.flush()
+
 def write_image(image, dest=None):
     """
     Writes an image to a file path or stdout.
     If dest is None, writes to stdout buffer.
+    Encoding and writing happen on a background thread (write-behind).
     """
     if image is None:
         return
 
     if dest:
         # Write to file
-        cv2.imwrite(dest, image)
+        _writer.submit(_write_file, image, dest)
     else:
         # Write to stdout
-        success, encoded_image = cv2.imencode('.png', image)
-        if success:
-            sys.stdout.buffer.write(encoded_image.tobytes())
+        _writer.submit(_write_stdout, image)
@@ -0,0 +1,106 @@
+import os
+import sys
+import struct
+import shutil
+import subprocess
+
+# Content fingerprints shared with the shell's `vhash` builtin. Digests are
+# read straight from the shell's persistent table, keyed by (dev, inode,
+# size, mtime_ns); files that are new or changed are hashed by running
+# `visionos --vhash`, which also adds them to the table for everyone else.
+#
+#   from fingerprint import fingerprint, fingerprints
+#   fingerprint("a.jpg")            -> "47124cdc091d81e3" or None
+#   fingerprints(["a.jpg", "b/"])   -> {"a.jpg": "...", ...}
+
+MAGIC = b"VOSFP001"
+RECORD = struct.Struct("=QQQqQ")   # dev, ino, size, mtime_ns, digest
+
+def table_path():
+    path = os.environ.get("VISIONOS_FP_TABLE")
+    if path:
+        return path
+    cache = os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache")
+    return os.path.join(cache, "visionos", "fingerprints")
+
+def shell_binary():
+    """The visionos binary: $VISIONOS_BIN, the one next to apps/, or on PATH."""
+    path = os.environ.get("VISIONOS_BIN")
+    if path:
+        return path
+    local = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), "visionos")
+    if os.access(local, os.X_OK):
+        return local
+    return shutil.which("visionos")
+
+class _Table:
+    """In-memory view of the table; only records appended since the last read are parsed."""
+    def __init__(self):
+        self.entries = {}   # (dev, ino) -> (size, mtime_ns, digest)
+        self.loaded = 0
+        self.ino = None
+
+    def sync(self):
+        try:
+            with open(table_path(), "rb") as f:
+                st = os.fstat(f.fileno())
+                if st.st_ino != self.ino or st.st_size < self.loaded:
+                    self.loaded = 0   # compacted by the shell
+                if self.loaded == 0:
+                    if f.read(len(MAGIC)) != MAGIC:
+                        return
+                    self.loaded = len(MAGIC)
+                    self.ino = st.st_ino
+                f.seek(self.loaded)
+                data = f.read()
+        except OSError:
+            return
+        usable = len(data) - len(data) % RECORD.size
+        for dev, ino, size, mtime_ns, digest in RECORD.iter_unpack(data[:usable]):
+            self.entries[(dev, ino)] = (size, mtime_ns, digest)
+        self.loaded += usable
+
+    def lookup(self, path):
+        try:
+            st = os.stat(path)
+        except OSError:
+            return None
+        entry = self.entries.get((st.st_dev, st.st_ino))
+        if entry and entry[0] == st.st_size and entry[1] == st.st_mtime_ns:
+            return f"{entry[2]:016x}"
+        return None
+
+_table = _Table()
+
+def fingerprints(paths):
+    """Digests of the given files (directories expand to the files inside them)."""
+    _table.sync()
+    result = {}
+    misses = []
+    for path in paths:
+        digest = None if os.path.isdir(path) else _table.lookup(path)
+        if digest:
+            result[path] = digest
+        else:
+            misses.append(path)
+    if not misses:
+        return result
+
+    binary = shell_binary()
+    if binary is None:
+        sys.stderr.write("fingerprint: visionos binary not found (set VISIONOS_BIN)\n")
+        return result
+    proc = subprocess.run([binary, "--vhash", *misses], stdout=subprocess.PIPE,
+                          stderr=subprocess.DEVNULL, text=True)
+    for line in proc.stdout.splitlines():
+        digest, _, path = line.partition("  ")
+        if path:
+            result[path] = digest
+    return result
+
+def fingerprint(path):
+    return fingerprints([path]).get(path)
+
+if __name__ == "__main__":
+    for path, digest in fingerprints(sys.argv[1:]).items():
+        print(f"{digest}  {path}")
@@ -0,0 +1,131 @@
+import os
+import struct
+
+# Header-only image probe: reads just enough of a file to report its
+# dimensions, bit depth, channel count and EXIF orientation without
+# decoding any pixels. Used by cv-info and `vls -a --long`.
+
+PROBE_BYTES = 64 * 1024
+
+PNG_CHANNELS = {0: 1, 2: 3, 3: 3, 4: 2, 6: 4}
+
+def _exif_orientation(tiff):
+    """Returns the Orientation tag (0x0112) from a TIFF-structured EXIF block."""
+    if len(tiff) < 8:
+        return 1
+    endian = {b'II': '<', b'MM': '>'}.get(tiff[:2])
+    if endian is None:
+        return 1
+    ifd = struct.unpack(endian + 'I', tiff[4:8])[0]
+    if ifd + 2 > len(tiff):
+        return 1
+    count = struct.unpack(endian + 'H', tiff[ifd:ifd + 2])[0]
+    for i in range(count):
+        entry = ifd + 2 + i * 12
+        if entry + 12 > len(tiff):
+            break
+        tag, _, _, value = struct.unpack(endian + 'HHIH', tiff[entry:entry + 10])
+        if tag == 0x0112:
+            return value if 1 <= value <= 8 else 1
+    return 1
+
+def _probe_png(f, head):
+    # IHDR is always the first chunk
+    if len(head) < 29 or head[12:16] != b'IHDR':
+        return None
+    width, height, depth, color = struct.unpack('>IIBB', head[16:26])
+    return dict(format='PNG', width=width, height=height, bit_depth=depth,
+                channels=PNG_CHANNELS.get(color, 3), orientation=1)
+
+def _probe_jpeg(f, head):
+    # Walk the marker segments until the first SOFn frame header
+    orientation = 1
+    pos = 2
+    while True:
+        f.seek(pos)
+        marker = f.read(4)
+        if len(marker) < 4 or marker[0] != 0xFF:
+            return None
+        code = marker[1]
+        if code == 0xFF:       # fill byte
+            pos += 1
+            continue
+        if code in (0xD8, 0x01) or 0xD0 <= code <= 0xD7:
+            pos += 2
+            continue
+        length = struct.unpack('>H', marker[2:4])[0]
+        if code == 0xE1:
+            segment = f.read(length - 2)
+            if segment[:6] == b'Exif\x00\x00':
+                orientation = _exif_orientation(segment[6:])
+        elif 0xC0 <= code <= 0xCF and code not in (0xC4, 0xC8, 0xCC):
+            sof = f.read(6)
+            if len(sof) < 6:
+                return None
+            depth, height, width, comps = struct.unpack('>BHHB', sof)
+            return dict(format='JPEG', width=width, height=height, bit_depth=depth,
+                        channels=comps, orientation=orientation)
+        elif code == 0xDA:     # start of scan without a frame header
+            return None
+        pos += 2 + length
+
+def _probe_bmp(f, head):
+    if len(head) < 30:
+        return None
+    width, height = struct.unpack('<ii', head[18:26])
+    bpp = struct.unpack('<H', head[28:30])[0]
+    channels = 4 if bpp == 32 else (3 if bpp in (16, 24) or bpp <= 8 else 1)
+    return dict(format='BMP', width=width, height=abs(height),
+                bit_depth=8 if bpp >= 16 else bpp, channels=channels, orientation=1)
+
+def _probe_webp(f, head):
+    info = dict(format='WebP', bit_depth=8, channels=3, orientation=1)
+    pos = 12
+    found = False
+    while pos + 8 <= len(head):
+        fourcc = head[pos:pos + 4]
+        size = struct.unpack('<I', head[pos + 4:pos + 8])[0]
+        data = head[pos + 8:pos + 8 + size]
+        if fourcc == b'VP8X' and len(data) >= 10:
+            info['channels'] = 4 if data[0] & 0x10 else 3
+            info['width'] = 1 + int.from_bytes(data[4:7], 'little')
+            info['height'] = 1 + int.from_bytes(data[7:10], 'little')
+            found = True
+        elif fourcc == b'VP8 ' and len(data) >= 10 and not found:
+            w, h = struct.unpack('<HH', data[6:10])
+            info.update(width=w & 0x3FFF, height=h & 0x3FFF)
+            found = True
+        elif fourcc == b'VP8L' and len(data) >= 5 and not found:
+            bits = int.from_bytes(data[1:5], 'little')
+            info.update(width=(bits & 0x3FFF) + 1, height=((bits >> 14) & 0x3FFF) + 1,
+                        channels=4 if (bits >> 28) & 1 else 3)
+            found = True
+        elif fourcc == b'EXIF':
+            tiff = data[6:] if data[:6] == b'Exif\x00\x00' else data
+            info['orientation'] = _exif_orientation(tiff)
+        pos += 8 + size + (size & 1)
+    return info if found else None
+
+def probe_image(path):
+    """
+    Returns a dict with format, width, height, bit_depth, channels,
+    orientation and file_size, or None if the header is not recognised.
+    """
+    try:
+        with open(path, 'rb') as f:
+            head = f.read(PROBE_BYTES)
+            if head[:8] == b'\x89PNG\r\n\x1a\n':
+                info = _probe_png(f, head)
+            elif head[:2] == b'\xff\xd8':
+                info = _probe_jpeg(f, head)
+            elif head[:2] == b'BM':
+                info = _probe_bmp(f, head)
+            elif head[:4] == b'RIFF' and head[8:12] == b'WEBP':
+                info = _probe_webp(f, head)
+            else:
+                info = None
+            if info is not None:
+                info['file_size'] = os.fstat(f.fileno()).st_size
+            return info
+    except (OSError, struct.error):
+        return None
@@ -0,0 +1,122 @@
+import os
+import sys
+import time
+import cv2
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+
+# Perceptual-hash index used by `vls --similar`. Each image is reduced to a
+# difference hash (dHash) of 64 or 256 bits, stored as packed uint64 words.
+# The index lives next to the images and only new or modified files are
+# hashed again on later runs. Entries are keyed by path relative to the
+# indexed directory, so `vls imgs` and `vls ./imgs` share them.
+
+INDEX_NAME = ".vls_phash.npz"
+
+def dhash(path, bits=64):
+    """Difference hash: sign of horizontal gradients on a (side+1) x side thumbnail."""
+    side = int(np.sqrt(bits))
+    # Reduced decode is much cheaper for large JPEGs; the hash only needs a thumbnail
+    img = cv2.imread(path, cv2.IMREAD_REDUCED_GRAYSCALE_8)
+    if img is None or min(img.shape[:2]) < side:
+        img = cv2.imread(path, cv2.IMREAD_GRAYSCALE)
+    if img is None:
+        return None
+    thumb = cv2.resize(img, (side + 1, side), interpolation=cv2.INTER_AREA)
+    diff = thumb[:, 1:] > thumb[:, :-1]
+    return np.packbits(diff.ravel()).view('>u8').astype(np.uint64)
+
+def load_index(directory, bits):
+    path = os.path.join(directory, INDEX_NAME)
+    try:
+        data = np.load(path, allow_pickle=False)
+        if int(data["bits"]) != bits:
+            return {}
+        return {
+            p: (int(s), int(m), h)
+            for p, s, m, h in zip(data["paths"], data["sizes"], data["mtimes"], data["hashes"])
+        }
+    except (OSError, KeyError, ValueError):
+        return {}
+
+def save_index(directory, bits, entries):
+    paths = sorted(entries)
+    words = bits // 64
+    tmp = os.path.join(directory, INDEX_NAME + ".tmp.npz")
+    np.savez(
+        tmp,
+        bits=bits,
+        paths=np.array(paths, dtype=str),
+        sizes=np.array([entries[p][0] for p in paths], dtype=np.int64),
+        mtimes=np.array([entries[p][1] for p in paths], dtype=np.int64),
+        hashes=np.array([entries[p][2] for p in paths], dtype=np.uint64).reshape(-1, words),
+    )
+    os.replace(tmp, os.path.join(directory, INDEX_NAME))
+
+def build_index(directory, image_files, bits=64, workers=None):
+    """
+    Returns (paths, hashes) for image_files, reusing cached hashes for
+    files whose size and mtime are unchanged.
+    """
+    start = time.perf_counter()
+    cached = load_index(directory, bits)
+    entries = {}     # key -> (size, mtime, hash)
+    given = {}       # key -> path as the caller spelled it
+    stale = []
+
+    for path in image_files:
+        try:
+            st = os.stat(path)
+        except OSError:
+            continue
+        key = os.path.relpath(path, directory)
+        given[key] = path
+        hit = cached.get(key)
+        if hit is not None and hit[0] == st.st_size and hit[1] == st.st_mtime_ns:
+            entries[key] = hit
+        else:
+            stale.append((key, st.st_size, st.st_mtime_ns))
+
+    # OpenCV releases the GIL while decoding, so threads scale across cores.
+    # Stay within the stage's thread budget and CPU slice from the shell.
+    if not workers:
+        workers = int(os.environ.get("VISIONOS_THREADS", 0)) or len(os.sched_getaffinity(0))
+    with ThreadPoolExecutor(max_workers=workers) as pool:
+        hashes = pool.map(lambda item: dhash(given[item[0]], bits), stale)
+        for (key, size, mtime), h in zip(stale, hashes):
+            if h is not None:
+                entries[key] = (size, mtime, h)
+
+    if stale:
+        # Keep hashes of files outside this run (e.g. subdirectories when
+        # not recursing) so alternating runs do not hash them again
+        merged = {k: e for k, e in cached.items()
+                  if k not in entries and os.path.exists(os.path.join(directory, k))}
+        merged.update(entries)
+        try:
+            save_index(directory, bits, merged)
+        except OSError as e:
+            sys.stderr.write(f"Warning: could not save index: {e}\n")
+
+    elapsed = time.perf_counter() - start
+    rate = len(stale) / elapsed if elapsed > 0 else 0.0
+    sys.stderr.write(f"Indexed {len(entries)} images ({len(stale)} hashed) "
+                     f"in {elapsed:.2f}s ({rate:.0f} img/s)\n")
+
+    keys = sorted(entries)
+    matrix = np.array([entries[k][2] for k in keys], dtype=np.uint64).reshape(-1, bits // 64)
+    return [given[k] for k in keys], matrix
+
+def query(ref_hash, paths, matrix, max_dist):
+    """Hamming scan over all hashes; returns [(distance, path)] sorted by distance."""
+    if len(paths) == 0:
+        return []
+    start = time.perf_counter()
+    # XOR + popcount per word, vectorised (numpy uses hardware popcount)
+    dist = np.bitwise_count(matrix ^ ref_hash).sum(axis=1, dtype=np.int32)
+    hits = np.nonzero(dist <= max_dist)[0]
+    order = hits[np.argsort(dist[hits], kind='stable')]
+    elapsed = time.perf_counter() - start
+    rate = len(paths) / elapsed if elapsed > 0 else 0.0
+    sys.stderr.write(f"Scanned {len(paths)} hashes in {elapsed * 1000:.2f}ms ({rate:.0f} hashes/s)\n")
+    return [(int(dist[i]), paths[i]) for i in order]
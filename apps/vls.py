@@ -3,6 +3,7 @@ import os
 import logging
 import argparse
 import signal
+from img_probe import probe_image
 
 def signal_handler(sig, frame):
     sys.exit(0)
@@ -19,18 +20,31 @@ def parse_arguments():
     parser.add_argument('directory', nargs='?', default='.', help='Target directory')
     parser.add_argument('-a', '--all', action='store_true', help='List all images')
     parser.add_argument('-R', '--recursive', action='store_true', help='Recursive search')
+    parser.add_argument('-l', '--long', action='store_true', help='Show dimensions, channels and format (header probe, no decoding)')
     parser.add_argument('--contains', nargs='+', help='Filter images containing these labels')
     parser.add_argument('--not-contains', nargs='+', help='Filter images NOT containing these labels')
+    parser.add_argument('--similar', metavar='REF', help='List images visually similar to REF (perceptual hash)')
+    parser.add_argument('--max-dist', type=int, default=None, help='Maximum Hamming distance for --similar (default: bits/6)')
+    parser.add_argument('--hash-bits', type=int, choices=[64, 256], default=64, help='Perceptual hash size for --similar (default: 64)')
+    parser.add_argument('--workers', type=int, default=0, help='Classify with N local worker processes')
+    parser.add_argument('--hosts', nargs='+', metavar='HOST:PORT', help='Also classify on these `vls --serve` workers')
+    parser.add_argument('--chunk-size', type=int, default=32, help='Largest chunk of files handed to a worker (default: 32)')
+    parser.add_argument('--serve', metavar='[HOST]:PORT', help='Run as a worker for other vls coordinators (default host: 127.0.0.1)')
+    parser.add_argument('--worker-connect', metavar='HOST:PORT', help=argparse.SUPPRESS)
     
     args = parser.parse_args()
 
+    # Worker processes take their job from the coordinator
+    if args.serve or args.worker_connect:
+        return args
+
     # Validation Logic
-    if args.directory != '.' and not (args.all or args.contains or args.not_contains):
-        print(f"Error: When specifying a directory '{args.directory}', you must specify a filter (--contains, --not-contains) or --all.")
+    if args.directory != '.' and not (args.all or args.contains or args.not_contains or args.similar):
+        print(f"Error: When specifying a directory '{args.directory}', you must specify a filter (--contains, --not-contains, --similar) or --all.")
         sys.exit(1)
 
     # Default behavior for current directory with no args
-    if args.directory == '.' and not (args.all or args.contains or args.not_contains):
+    if args.directory == '.' and not (args.all or args.contains or args.not_contains or args.similar):
         args.all = True
         
     return args
@@ -41,6 +55,11 @@ def load_model():
         from ultralytics import YOLO
         
         device = 'cuda' if torch.cuda.is_available() else 'cpu'
+
+        # Respect the thread budget the shell gave this stage
+        threads = int(os.environ.get("VISIONOS_THREADS", 0))
+        if threads > 0:
+            torch.set_num_threads(threads)
         # Using yolo11s.pt (Small, for better accuracy while still fast)
         model = YOLO('yolo11s.pt')
         return model, device
@@ -75,7 +94,18 @@ def gather_images(target_dir, recursive=False):
              
     return image_files
 
-def filter_results(results, target_contains, target_not_contains):
+def print_image(path, long=False):
+    if not long:
+        print(path)
+        return
+    info = probe_image(path)
+    if info is None:
+        print(f"{'?':>11}  {'?':>2}  {'?':<5}  {path}")
+    else:
+        size = f"{info['width']}x{info['height']}"
+        print(f"{size:>11}  {info['channels']:>2}  {info['format']:<5}  {path}")
+
+def matching_paths(results, target_contains, target_not_contains):
     for result in results:
         detected_classes = set()
         if result.boxes:
@@ -96,11 +126,62 @@ def filter_results(results, target_contains, target_not_contains):
                 keep = False
                 
         if keep:
-            # Print path
-            print(result.path)
+            yield result.path
+
+def filter_results(results, target_contains, target_not_contains, long=False):
+    for path in matching_paths(results, target_contains, target_not_contains):
+        print_image(path, long)
+
+def make_classifier():
+    """Worker side: classify a chunk of paths, loading the model on first use."""
+    state = {}
+
+    def classify(paths, job):
+        if 'model' not in state:
+            state['model'], state['device'] = load_model()
+        contains = set(job['contains']) if job['contains'] else None
+        not_contains = set(job['not_contains']) if job['not_contains'] else None
+        results = state['model'](paths, device=state['device'], stream=True, verbose=False, conf=0.05)
+        return list(matching_paths(results, contains, not_contains))
+    return classify
+
+def classify_distributed(args, image_files, target_contains, target_not_contains):
+    from vls_cluster import run_coordinator
+
+    job = dict(contains=sorted(target_contains or []), not_contains=sorted(target_not_contains or []))
+    worker_cmd = [sys.executable, os.path.abspath(__file__), '--worker-connect']
+    ok = run_coordinator(image_files, job, lambda path: print_image(path, args.long),
+                         workers=args.workers, hosts=args.hosts, worker_cmd=worker_cmd,
+                         max_chunk=args.chunk_size)
+    sys.exit(0 if ok else 1)
+
+def find_similar(args, image_files):
+    from phash_index import dhash, build_index, query
+
+    ref_hash = dhash(args.similar, args.hash_bits)
+    if ref_hash is None:
+        print(f"Error: Could not read reference image '{args.similar}'.")
+        sys.exit(1)
+
+    max_dist = args.max_dist if args.max_dist is not None else args.hash_bits // 6
+    paths, matrix = build_index(args.directory, image_files, args.hash_bits)
+    for dist, path in query(ref_hash, paths, matrix, max_dist):
+        if args.long:
+            print(f"{dist:>4}  ", end="")
+            print_image(path, True)
+        else:
+            print(f"{dist:>4}  {path}")
 
 def main():
     args = parse_arguments()
+
+    if args.serve or args.worker_connect:
+        import vls_cluster
+        if args.serve:
+            vls_cluster.serve(args.serve, make_classifier())
+        else:
+            vls_cluster.connect_worker(args.worker_connect, make_classifier())
+        sys.exit(0)
     
     target_contains = set(x.lower() for x in args.contains) if args.contains else None
     target_not_contains = set(x.lower() for x in args.not_contains) if args.not_contains else None
@@ -110,12 +191,21 @@ def main():
     if not image_files:
         sys.exit(0)
 
+    # Similarity search uses the perceptual-hash index, not the detector
+    if args.similar:
+        find_similar(args, image_files)
+        sys.exit(0)
+
     # If --all is specified, we don't need to run inference
     if args.all:
         for img in image_files:
-            print(img)
+            print_image(img, args.long)
         sys.exit(0)
 
+    # Shard the detector over worker processes and/or hosts
+    if args.workers > 0 or args.hosts:
+        classify_distributed(args, image_files, target_contains, target_not_contains)
+
     model, device = load_model()
 
     # Run Inference
@@ -123,7 +213,7 @@ def main():
     # conf=0.05 
     results = model(image_files, device=device, stream=True, verbose=False, conf=0.05)
 
-    filter_results(results, target_contains, target_not_contains)
+    filter_results(results, target_contains, target_not_contains, args.long)
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,327 @@
+import os
+import sys
+import json
+import time
+import socket
+import threading
+import subprocess
+from collections import deque
+
+# Coordinator/worker mode for `vls --workers N` and `vls --hosts ...`.
+# The coordinator holds the file list and hands it out in chunks on request,
+# so fast workers simply pull more (work stealing for uneven shards). Once
+# the list is exhausted, idle workers re-run the oldest chunk still in
+# flight elsewhere; whichever copy finishes first wins. Matches are printed
+# as each chunk comes back.
+#
+# Protocol: one JSON object per line over TCP.
+#   coordinator -> worker  {"op": "job", "contains": [...], "not_contains": [...]}
+#   worker -> coordinator  {"op": "hello", "name": "host:pid"}
+#   worker -> coordinator  {"op": "pull"}
+#   coordinator -> worker  {"op": "chunk", "id": 3, "paths": [...]} or {"op": "done"}
+#   worker -> coordinator  {"op": "results", "id": 3, "kept": [...], "seconds": 1.2}
+#
+# Remote workers (`vls --serve HOST:7000`) must see the images under the same
+# paths. The protocol has no authentication, so a worker listens on loopback
+# unless it is given an address to bind.
+
+DEFAULT_CHUNK = 32
+STRAGGLER_RATIO = 0.5
+
+def parse_address(addr, default_host="127.0.0.1"):
+    host, _, port = addr.rpartition(":")
+    return (host or default_host, int(port))
+
+def send_msg(f, msg):
+    f.write(json.dumps(msg).encode() + b"\n")
+    f.flush()
+
+def recv_msg(f):
+    line = f.readline()
+    if not line:
+        return None
+    return json.loads(line)
+
+# ---------------------------------------------------------------- worker side
+
+def run_session(sock, classify):
+    """Serve one coordinator: pull chunks until told we are done."""
+    f = sock.makefile("rwb")
+    try:
+        job = recv_msg(f)
+        if job is None or job.get("op") != "job":
+            return
+        send_msg(f, {"op": "hello", "name": f"{socket.gethostname()}:{os.getpid()}"})
+        while True:
+            send_msg(f, {"op": "pull"})
+            msg = recv_msg(f)
+            if msg is None or msg["op"] != "chunk":
+                break
+            start = time.perf_counter()
+            kept = classify(msg["paths"], job)
+            send_msg(f, {"op": "results", "id": msg["id"], "kept": kept,
+                         "seconds": time.perf_counter() - start})
+    except (OSError, ValueError):
+        pass
+    finally:
+        f.close()
+        sock.close()
+
+def connect_worker(addr, classify):
+    """Local worker started by the coordinator: connect back and serve once."""
+    sock = socket.create_connection(parse_address(addr))
+    run_session(sock, classify)
+
+def serve(addr, classify):
+    """Long-lived worker for other hosts; the model stays loaded between runs."""
+    server = socket.create_server(parse_address(addr))
+    sys.stderr.write(f"vls worker listening on {server.getsockname()[0]}:{server.getsockname()[1]}\n")
+    while True:
+        sock, peer = server.accept()
+        sys.stderr.write(f"Coordinator {peer[0]}:{peer[1]} connected\n")
+        run_session(sock, classify)
+
+# ----------------------------------------------------------- coordinator side
+
+class WorkerStats:
+    def __init__(self, name):
+        self.name = name
+        self.images = 0
+        self.chunks = 0
+        self.busy = 0.0
+        self.speculative = 0
+        self.wasted = 0
+
+    def rate(self):
+        return self.images / self.busy if self.busy > 0 else 0.0
+
+class Coordinator:
+    def __init__(self, paths, job, max_chunk, on_match):
+        self.pending = deque(paths)
+        self.total = len(paths)
+        self.job = job
+        self.max_chunk = max_chunk
+        self.on_match = on_match
+        self.cond = threading.Condition()
+        self.chunks = {}     # id -> paths, while in flight
+        self.sizes = {}      # id -> number of paths
+        self.inflight = {}   # id -> [(worker, start)]
+        self.completed = 0
+        self.next_id = 0
+        self.live = 0
+        self.connecting = 0
+        self.workers = []
+
+    def finished(self):
+        return self.completed == self.total
+
+    def _take_chunk(self, worker):
+        if self.pending:
+            # Guided chunking: large chunks early, small ones near the end
+            size = len(self.pending) // (2 * max(self.live, 1))
+            size = max(1, min(self.max_chunk, size))
+            paths = [self.pending.popleft() for _ in range(min(size, len(self.pending)))]
+            cid = self.next_id
+            self.next_id += 1
+            self.chunks[cid] = paths
+            self.sizes[cid] = len(paths)
+            self.inflight[cid] = [(worker, time.perf_counter())]
+            return cid, paths
+        # Tail: duplicate the oldest chunk running on another worker only
+        oldest = sorted(self.inflight.items(), key=lambda kv: kv[1][0][1])
+        for cid, holders in oldest:
+            if len(holders) == 1 and holders[0][0] is not worker:
+                holders.append((worker, time.perf_counter()))
+                worker.speculative += 1
+                return cid, self.chunks[cid]
+        return None
+
+    def next_chunk(self, worker):
+        """Blocks until there is work for this worker, or returns None when all is done."""
+        with self.cond:
+            while True:
+                if self.finished():
+                    return None
+                chunk = self._take_chunk(worker)
+                if chunk is not None:
+                    return chunk
+                self.cond.wait()
+
+    def complete(self, worker, cid, kept, seconds):
+        with self.cond:
+            worker.busy += seconds
+            worker.chunks += 1
+            holders = self.inflight.get(cid)
+            if holders is None:
+                # Another copy of this chunk finished first
+                worker.wasted += self.sizes[cid]
+                return
+            worker.images += self.sizes[cid]
+            del self.inflight[cid]
+            del self.chunks[cid]
+            self.completed += self.sizes[cid]
+            for path in kept:
+                self.on_match(path)
+            self.cond.notify_all()
+
+    def drop(self, worker):
+        """A worker went away: give its unfinished chunks back to the queue."""
+        with self.cond:
+            self.live -= 1
+            for cid in list(self.inflight):
+                holders = [h for h in self.inflight[cid] if h[0] is not worker]
+                if holders:
+                    self.inflight[cid] = holders
+                else:
+                    del self.inflight[cid]
+                    self.pending.extendleft(reversed(self.chunks.pop(cid)))
+            self.cond.notify_all()
+
+    def handle(self, sock):
+        f = sock.makefile("rwb")
+        worker = None
+        try:
+            send_msg(f, dict(op="job", **self.job))
+            hello = recv_msg(f)
+            if hello is None:
+                return
+            worker = WorkerStats(hello.get("name", "?"))
+            with self.cond:
+                self.workers.append(worker)
+                self.live += 1
+                self.connecting -= 1
+            while True:
+                msg = recv_msg(f)
+                if msg is None:
+                    if not self.finished():
+                        sys.stderr.write(f"Worker {worker.name} disconnected\n")
+                    break
+                if msg["op"] == "pull":
+                    chunk = self.next_chunk(worker)
+                    if chunk is None:
+                        send_msg(f, {"op": "done"})
+                        break
+                    send_msg(f, {"op": "chunk", "id": chunk[0], "paths": chunk[1]})
+                elif msg["op"] == "results":
+                    self.complete(worker, msg["id"], msg["kept"], msg["seconds"])
+        except (OSError, ValueError) as e:
+            sys.stderr.write(f"Worker {worker.name if worker else '?'} failed: {e}\n")
+        finally:
+            if worker is not None:
+                self.drop(worker)
+            else:
+                with self.cond:
+                    self.connecting -= 1
+                    self.cond.notify_all()
+            f.close()
+            sock.close()
+
+    def report(self, elapsed):
+        out = sys.stderr
+        out.write(f"\n{'Worker':<24} {'Images':>7} {'Chunks':>6} {'Busy':>8} {'img/s':>8}\n")
+        for w in self.workers:
+            out.write(f"{w.name:<24} {w.images:>7} {w.chunks:>6} {w.busy:>7.1f}s {w.rate():>8.1f}\n")
+
+        rates = sorted(w.rate() for w in self.workers if w.busy > 0)
+        if rates:
+            median = rates[len(rates) // 2]
+            slow = [w for w in self.workers if w.busy > 0 and w.rate() < STRAGGLER_RATIO * median]
+            for w in slow:
+                out.write(f"Straggler: {w.name} at {w.rate() / median:.2f}x the median throughput\n")
+        reissued = sum(w.speculative for w in self.workers)
+        if reissued:
+            wasted = sum(w.wasted for w in self.workers)
+            out.write(f"Re-issued {reissued} tail chunks; {wasted} images classified twice\n")
+        rate = self.total / elapsed if elapsed > 0 else 0.0
+        out.write(f"Total: {self.total} images in {elapsed:.1f}s ({rate:.1f} img/s) "
+                  f"on {len(self.workers)} workers\n")
+
+def run_coordinator(paths, job, on_match, workers=0, hosts=None, worker_cmd=None,
+                    max_chunk=DEFAULT_CHUNK):
+    """
+    Classify paths on `workers` local processes (started with worker_cmd +
+    [address]) and/or the `vls --serve` workers at hosts. on_match(path) is
+    called as results arrive. Returns False if the run could not finish.
+    """
+    coordinator = Coordinator(paths, job, max_chunk, on_match)
+    start = time.perf_counter()
+    threads = []
+    procs = []
+    accepted = []
+
+    def start_handler(sock):
+        with coordinator.cond:
+            coordinator.connecting += 1
+        t = threading.Thread(target=coordinator.handle, args=(sock,), daemon=True)
+        t.start()
+        threads.append(t)
+
+    for host in hosts or []:
+        try:
+            sock = socket.create_connection(parse_address(host), timeout=10)
+            sock.settimeout(None)
+            start_handler(sock)
+        except OSError as e:
+            sys.stderr.write(f"Cannot reach worker {host}: {e}\n")
+
+    if workers > 0:
+        server = socket.create_server(("127.0.0.1", 0))
+        address = f"127.0.0.1:{server.getsockname()[1]}"
+
+        # Split this stage's thread budget between the local workers
+        budget = int(os.environ.get("VISIONOS_THREADS", 0)) or os.cpu_count() or 1
+        env = dict(os.environ)
+        for var in ("VISIONOS_THREADS", "OMP_NUM_THREADS"):
+            env[var] = str(max(1, budget // workers))
+        for _ in range(workers):
+            # Worker output (e.g. a failed model load) goes to our stderr,
+            # away from the matches on stdout
+            procs.append(subprocess.Popen(worker_cmd + [address], env=env, stdout=sys.stderr))
+
+        def accept_loop():
+            for _ in range(workers):
+                try:
+                    sock, _ = server.accept()
+                except OSError:
+                    return
+                start_handler(sock)
+                accepted.append(sock)
+        threading.Thread(target=accept_loop, daemon=True).start()
+
+    exited = set()
+    def report_exits():
+        for p in procs:
+            if p.pid in exited or p.poll() is None:
+                continue
+            exited.add(p.pid)
+            if p.returncode < 0:
+                sys.stderr.write(f"Local worker {p.pid} killed by signal {-p.returncode}\n")
+            elif p.returncode != 0:
+                sys.stderr.write(f"Local worker {p.pid} exited with status {p.returncode}\n")
+
+    # Wait for the work to finish, or for every worker to be gone
+    ok = True
+    with coordinator.cond:
+        while not coordinator.finished():
+            coordinator.cond.wait(timeout=0.5)
+            report_exits()
+            # Local workers may still be importing torch and connecting back
+            starting = coordinator.connecting > 0 or (
+                len(accepted) < len(procs) and any(p.poll() is None for p in procs))
+            if coordinator.live == 0 and not starting:
+                sys.stderr.write("Error: No workers left; "
+                                 f"{coordinator.total - coordinator.completed} images unclassified\n")
+                ok = False
+                break
+
+    for t in threads:
+        t.join(timeout=5)
+    for p in procs:
+        try:
+            p.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            exited.add(p.pid)
+            p.kill()
+    report_exits()
+    coordinator.report(time.perf_counter() - start)
+    return ok
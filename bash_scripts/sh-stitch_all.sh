@@ -1,21 +1,29 @@
 #!/usr/bin/env bash
 
 # sh-stitch-all: Iteratively stitch all images in a folder
-# Usage: ./sh-stitch-all path/to/images_dir final_output.png
+# Usage: ./sh-stitch-all path/to/images_dir final_output.png [--retrieve]
+#   --retrieve  Order images by the cv-pairs match graph instead of by filename
 
 IMG_DIR=$1
 FINAL_OUT=$2
+MODE=$3
 TEMP_OUT="temp_panorama.png"
 APP_PATH="./apps/cv_stitch.py" # Adjust based on your directory structure
+PAIRS_PATH="./apps/cv_pairs.py"
 
 # Check arguments
 if [[ -z "$IMG_DIR" || -z "$FINAL_OUT" ]]; then
-    echo "Usage: $0 <directory_of_images> <final_output_name>"
+    echo "Usage: $0 <directory_of_images> <final_output_name> [--retrieve]"
     exit 1
 fi
 
-# Get all images in a sorted list
-images=($(ls "$IMG_DIR"/*.{jpg,png,jpeg} 2>/dev/null | sort))
+if [[ "$MODE" == "--retrieve" ]]; then
+    # Overlap order from the retrieval index; unconnected images are skipped
+    mapfile -t images < <(python3 "$PAIRS_PATH" "$IMG_DIR" --order)
+else
+    # Get all images in a sorted list
+    images=($(ls "$IMG_DIR"/*.{jpg,png,jpeg} 2>/dev/null | sort))
+fi
 
 # Check if we have at least 2 images
 if [ ${#images[@]} -lt 2 ]; then
@@ -0,0 +1,133 @@
+#!/bin/bash
+
+# VisionOS Script Mode and Fan-out Test Script
+# Runs small batch scripts and fan-out lines through ./visionos and checks
+# their output, the files they leave and the exit codes.
+# Run from the repository root after `make`.
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+# Keep the fingerprint table and image cache of the tests out of the user's
+export VISIONOS_FP_TABLE="$WORK/fingerprints"
+export VISIONOS_CACHE_DIR="$WORK/cache"
+FAILED=0
+
+check() {
+    # check "description" <condition...>
+    local desc="$1"
+    shift
+    if "$@"; then
+        echo "  ✓ $desc"
+    else
+        echo "  ✗ $desc"
+        FAILED=$((FAILED + 1))
+    fi
+}
+
+# run_script NAME: runs $WORK/NAME.vos, output in $WORK/NAME.out/.err, status in $STATUS
+run_script() {
+    ./visionos -f "$WORK/$1.vos" -j "${2:-1}" > "$WORK/$1.out" 2> "$WORK/$1.err" < /dev/null
+    STATUS=$?
+}
+
+echo "======================================"
+echo "VisionOS Script Mode Tests"
+echo "======================================"
+echo ""
+
+# Script lines are split on blanks, with no quoting: helpers live in files
+printf 'exit 3\n' > "$WORK/fail3.sh"
+printf 'sleep 0.3\necho first\n' > "$WORK/slow.sh"
+
+echo "Test 1: Exit Status"
+echo "-------------------"
+printf 'echo one\ntrue\n' > "$WORK/ok.vos"
+run_script ok
+check "all lines succeed -> 0" [ "$STATUS" -eq 0 ]
+check "output replayed" grep -qx "one" "$WORK/ok.out"
+
+printf 'echo a\nbash %s/fail3.sh\necho b\n' "$WORK" > "$WORK/fail.vos"
+run_script fail
+check "first failing status is returned (3)" [ "$STATUS" -eq 3 ]
+check "independent line after a failure still runs" grep -qx "b" "$WORK/fail.out"
+
+printf 'false\nexit\necho after\n' > "$WORK/exit.vos"
+run_script exit
+check "exit returns the status so far (1)" [ "$STATUS" -eq 1 ]
+check "lines after exit do not run" bash -c "! grep -q after '$WORK/exit.out'"
+echo ""
+
+echo "Test 2: Dependency Inference"
+echo "----------------------------"
+cat > "$WORK/deps.vos" <<EOF
+false > $WORK/a.txt
+cat $WORK/a.txt > $WORK/b.txt
+echo unrelated > $WORK/c.txt
+cat $WORK/b.txt
+EOF
+run_script deps 4
+check "reader of a failed line's output is skipped" grep -q ":2: skipped" "$WORK/deps.err"
+check "skip propagates through files (line 4)" grep -q ":4: skipped" "$WORK/deps.err"
+check "unrelated line runs" grep -qx "unrelated" "$WORK/c.txt"
+
+cat > "$WORK/barrier.vos" <<EOF
+false
+cache-stats
+cd $WORK
+echo moved > moved.txt
+vhash moved.txt
+EOF
+run_script barrier 2
+check "read-only builtin after a failure runs" grep -q "Image Cache" "$WORK/barrier.out"
+check "cd barrier runs after a failure" [ -f "$WORK/moved.txt" ]
+check "line after the barrier sees the new directory" grep -q "  moved.txt" "$WORK/barrier.out"
+check "nothing is skipped" bash -c "! grep -q skipped '$WORK/barrier.err'"
+
+cat > "$WORK/order.vos" <<EOF
+bash $WORK/slow.sh > $WORK/o.txt
+cat $WORK/o.txt
+echo parallel
+EOF
+run_script order 3
+check "read-after-write waits for the writer" grep -qx "first" "$WORK/order.out"
+check "output stays in script order" bash -c "[ \"\$(tail -1 '$WORK/order.out')\" = parallel ]"
+
+printf 'cat\n' > "$WORK/stdin.vos"
+timeout 10 ./visionos -f "$WORK/stdin.vos" > /dev/null 2>&1
+check "lines read /dev/null, not the shell's stdin" [ $? -ne 124 ]
+echo ""
+
+echo "Test 3: Fan-out"
+echo "---------------"
+printf 'echo x |& { cat > %s/f1.txt ; cat > %s/f2.txt }\n' "$WORK" "$WORK" > "$WORK/fan.vos"
+run_script fan
+check "every branch gets the stream" bash -c "grep -qx x '$WORK/f1.txt' && grep -qx x '$WORK/f2.txt'"
+check "fan-out line succeeds" [ "$STATUS" -eq 0 ]
+
+printf 'echo x |& { cat > /dev/null ; false }\n' > "$WORK/fanfail.vos"
+run_script fanfail
+check "a failing branch fails the line" [ "$STATUS" -ne 0 ]
+
+for line in 'echo x |& cat' 'echo x |& { cat } trailing' 'echo x |& { ; }'; do
+    printf '%s\n' "$line" > "$WORK/syntax.vos"
+    run_script syntax
+    check "syntax error: $line" bash -c "[ $STATUS -eq 2 ] && grep -q 'Syntax error' '$WORK/syntax.err'"
+done
+
+if python3 -c "import cv2" 2> /dev/null; then
+    IMG=$(ls test_imgs/*.jp* | head -1)
+    printf 'cv-gaussian %s |& { cv-edge > %s/e.png ; cv-togray -o %s/g.png }\n' "$IMG" "$WORK" "$WORK" > "$WORK/cvfan.vos"
+    run_script cvfan
+    check "cv branches write PNGs (redirect and -o)" \
+        bash -c "file '$WORK/e.png' | grep -q PNG && file '$WORK/g.png' | grep -q PNG"
+fi
+echo ""
+
+echo "======================================"
+if [ "$FAILED" -eq 0 ]; then
+    echo "All Script Mode Tests Passed!"
+else
+    echo "$FAILED Script Mode Test(s) Failed"
+fi
+echo "======================================"
+exit $((FAILED > 0))
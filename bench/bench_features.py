@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+import os
+import sys
+import time
+import argparse
+import itertools
+import cv2
+
+# Compares the feature types of cv-match/cv-stitch on overlapping image
+# pairs: keypoints, ratio-test matches, RANSAC inliers and runtime of
+# detection + matching + RANSAC (median of several runs).
+#
+# Usage: python3 bench/bench_features.py [images...] [--runs N]
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sys.path.insert(0, os.path.join(ROOT, "apps"))
+
+from cv_match import FEATURES, detect_features, match_descriptors, RANSAC_filter
+
+def run_pair(img1, img2, features, max_keypoints, runs):
+    times = []
+    for _ in range(runs):
+        start = time.perf_counter()
+        kp1, des1 = detect_features(img1, features, max_keypoints)
+        kp2, des2 = detect_features(img2, features, max_keypoints)
+        t_detect = time.perf_counter()
+        good = match_descriptors(des1, des2) if des1 is not None and des2 is not None else []
+        t_match = time.perf_counter()
+        mask = RANSAC_filter(kp1, kp2, good)
+        end = time.perf_counter()
+        times.append((t_detect - start, t_match - t_detect, end - start))
+    times.sort(key=lambda t: t[2])
+    detect, match, total = times[len(times) // 2]
+    inliers = int(sum(mask)) if mask is not None else 0
+    return len(kp1), len(kp2), len(good), inliers, detect, match, total
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark SIFT/ORB/AKAZE matching on image pairs.")
+    default_images = [os.path.join(ROOT, "test_imgs", f"pan{i}.jpeg") for i in (1, 2, 3)]
+    parser.add_argument("images", nargs="*", default=default_images, help="Images; every pair is matched")
+    parser.add_argument("--runs", type=int, default=5, help="Runs per measurement (default=5)")
+    parser.add_argument("--max_keypoints", "-k", type=int, default=None, help="Keypoint cap (default: per detector)")
+    args = parser.parse_args()
+
+    cv2.setNumThreads(int(os.environ.get("VISIONOS_THREADS", 0)) or -1)
+    images = {p: cv2.imread(p) for p in args.images}
+    missing = [p for p, img in images.items() if img is None]
+    if missing:
+        sys.stderr.write(f"Error: Could not read {', '.join(missing)}\n")
+        sys.exit(1)
+
+    available = [f for f in FEATURES if f != "akaze" or hasattr(cv2, "AKAZE_create")]
+    print(f"{'pair':<26} {'features':<8} {'kp1':>6} {'kp2':>6} {'matches':>8} {'inliers':>8} "
+          f"{'detect':>9} {'match':>9} {'total':>9}")
+    for p1, p2 in itertools.combinations(args.images, 2):
+        pair = f"{os.path.basename(p1)}-{os.path.basename(p2)}"
+        for features in available:
+            kp1, kp2, matches, inliers, detect, match, total = run_pair(
+                images[p1], images[p2], features, args.max_keypoints, args.runs)
+            print(f"{pair:<26} {features:<8} {kp1:>6} {kp2:>6} {matches:>8} {inliers:>8} "
+                  f"{detect * 1000:>7.1f}ms {match * 1000:>7.1f}ms {total * 1000:>7.1f}ms")
+    skipped = set(FEATURES) - set(available)
+    if skipped:
+        print(f"Skipped (not in this OpenCV build): {', '.join(sorted(skipped))}")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+import os
+import sys
+import time
+import argparse
+import tempfile
+import numpy as np
+import cv2
+
+# Thumbnailing large JPEGs the old way (full decode, then INTER_LINEAR) and
+# the way cv-resize does it now (decode at 1/2, 1/4 or 1/8 scale, then
+# INTER_AREA). Quality is the PSNR of each against a full decode followed
+# by INTER_AREA, which does not alias.
+#
+# Usage: python3 bench/bench_resize.py [jpegs...] [--width 640] [--runs N]
+# Without files, synthetic 24 MP JPEGs are generated in a temp directory.
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sys.path.insert(0, os.path.join(ROOT, "apps"))
+os.environ["VISIONOS_CACHE"] = "0"  # measure decoding, not the cache
+
+from cv_utils import read_scaled
+
+def synthetic_jpeg(path, width, height, seed):
+    """Gradients, fine stripes (to show aliasing), shapes and sensor-like noise."""
+    rng = np.random.default_rng(seed)
+    x = np.linspace(0, 1, width, dtype=np.float32)
+    y = np.linspace(0, 1, height, dtype=np.float32)[:, None]
+    img = np.empty((height, width, 3), np.float32)
+    img[..., 0] = 255 * x
+    img[..., 1] = 255 * y
+    img[..., 2] = 127 + 120 * np.sin(2 * np.pi * (x * 900 + y * 40))
+    for _ in range(60):
+        cx, cy = int(rng.integers(width)), int(rng.integers(height))
+        color = tuple(int(c) for c in rng.integers(0, 256, 3))
+        cv2.circle(img, (cx, cy), int(rng.integers(20, 400)), color, -1)
+    img += rng.normal(0, 2, img.shape).astype(np.float32)
+    cv2.imwrite(path, np.clip(img, 0, 255).astype(np.uint8), [cv2.IMWRITE_JPEG_QUALITY, 92])
+
+def target_size(width):
+    return lambda w, h: (width, int(h * (width / w)))
+
+def old_resize(path, width):
+    img = cv2.imread(path)
+    size = target_size(width)(img.shape[1], img.shape[0])
+    return cv2.resize(img, size, interpolation=cv2.INTER_LINEAR)
+
+def new_resize(path, width):
+    img, size = read_scaled(path, target_size(width))
+    return cv2.resize(img, size, interpolation=cv2.INTER_AREA)
+
+def reference(path, width):
+    img = cv2.imread(path)
+    size = target_size(width)(img.shape[1], img.shape[0])
+    return cv2.resize(img, size, interpolation=cv2.INTER_AREA)
+
+def median_time(fn, path, width, runs):
+    times = []
+    for _ in range(runs):
+        start = time.perf_counter()
+        out = fn(path, width)
+        times.append(time.perf_counter() - start)
+    return sorted(times)[len(times) // 2], out
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark decode-time downscaling in cv-resize.")
+    parser.add_argument("images", nargs="*", help="JPEG files (default: generated 24 MP images)")
+    parser.add_argument("--width", "-W", type=int, default=640, help="Thumbnail width (default=640)")
+    parser.add_argument("--runs", type=int, default=5, help="Runs per measurement (default=5)")
+    args = parser.parse_args()
+
+    cv2.setNumThreads(int(os.environ.get("VISIONOS_THREADS", 0)) or -1)
+    tmp = None
+    images = args.images
+    if not images:
+        tmp = tempfile.TemporaryDirectory()
+        images = []
+        for i, (w, h) in enumerate([(6000, 4000), (4000, 6000), (5472, 3648)]):
+            path = os.path.join(tmp.name, f"synthetic_{w}x{h}.jpg")
+            synthetic_jpeg(path, w, h, i)
+            images.append(path)
+
+    print(f"{'image':<28} {'full+linear':>12} {'reduced+area':>13} {'speedup':>8} "
+          f"{'PSNR old':>9} {'PSNR new':>9}")
+    total_old = total_new = 0.0
+    for path in images:
+        old_t, old_out = median_time(old_resize, path, args.width, args.runs)
+        new_t, new_out = median_time(new_resize, path, args.width, args.runs)
+        ref = reference(path, args.width)
+        total_old += old_t
+        total_new += new_t
+        print(f"{os.path.basename(path):<28} {old_t * 1000:>10.1f}ms {new_t * 1000:>11.1f}ms "
+              f"{old_t / new_t:>7.1f}x {cv2.PSNR(old_out, ref):>7.1f}dB {cv2.PSNR(new_out, ref):>7.1f}dB")
+    print(f"{'total':<28} {total_old * 1000:>10.1f}ms {total_new * 1000:>11.1f}ms "
+          f"{total_old / total_new:>7.1f}x")
+    if tmp:
+        tmp.cleanup()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+import os
+import sys
+import time
+import argparse
+import tempfile
+import subprocess
+import numpy as np
+import cv2
+
+# Sustained frames per second of a two-stage filter pipeline on a 1080p
+# image sequence: one process pair per frame with PNG between the stages
+# (the one-image-per-process model) against one streaming pipeline that
+# passes raw VOSF frames.
+#
+# Usage: python3 bench/bench_stream.py [--frames N] [--per-frame N]
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+APPS = os.path.join(ROOT, "apps")
+
+def make_frames(directory, count, width=1920, height=1080):
+    rng = np.random.default_rng(0)
+    base = rng.integers(0, 256, (height // 8, width // 8, 3), dtype=np.uint8)
+    base = cv2.resize(base, (width, height), interpolation=cv2.INTER_CUBIC)
+    for i in range(count):
+        frame = np.roll(base, 8 * i, axis=1)
+        cv2.putText(frame, f"{i:05d}", (60, 200), cv2.FONT_HERSHEY_SIMPLEX, 5, (255, 255, 255), 8)
+        cv2.imwrite(os.path.join(directory, f"frame_{i:05d}.jpg"), frame)
+
+def app(name):
+    return ["python3", os.path.join(APPS, name)]
+
+def per_frame(paths):
+    start = time.perf_counter()
+    for path in paths:
+        first = subprocess.Popen(app("cv_gaussian.py") + [path], stdout=subprocess.PIPE)
+        subprocess.run(app("cv_edge.py"), stdin=first.stdout, stdout=subprocess.DEVNULL, check=True)
+        first.stdout.close()
+        first.wait()
+    return len(paths) / (time.perf_counter() - start)
+
+def streamed(directory, count):
+    start = time.perf_counter()
+    first = subprocess.Popen(app("cv_gaussian.py") + [directory], stdout=subprocess.PIPE)
+    subprocess.run(app("cv_edge.py"), stdin=first.stdout, stdout=subprocess.DEVNULL, check=True)
+    first.stdout.close()
+    first.wait()
+    return count / (time.perf_counter() - start)
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark 1080p stream mode throughput.")
+    parser.add_argument("--frames", type=int, default=60, help="Frames in the sequence (default=60)")
+    parser.add_argument("--per-frame", type=int, default=10,
+                        help="Frames run one process pair at a time (default=10)")
+    args = parser.parse_args()
+
+    os.environ["VISIONOS_CACHE"] = "0"  # every frame is decoded, as on first sight
+    with tempfile.TemporaryDirectory() as tmp:
+        make_frames(tmp, args.frames)
+        paths = sorted(os.path.join(tmp, name) for name in os.listdir(tmp))
+        slow = per_frame(paths[:args.per_frame])
+        fast = streamed(tmp, args.frames)
+    print(f"cv-gaussian | cv-edge on 1920x1080 JPEG frames ({os.cpu_count()} CPUs)")
+    print(f"  process per frame: {slow:6.1f} frames/s")
+    print(f"  stream mode:       {fast:6.1f} frames/s ({fast / slow:.1f}x)")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/wait.h>
+
+// Spawn latency against parent RSS: fork()+execv() versus posix_spawn().
+// The parent first touches a ballast buffer of the given size, the way the
+// shell holds history and cache buffers, then launches /bin/true repeatedly.
+//
+// Usage: bench/spawn_bench [-n iterations] [ballast MB ...]
+
+extern char **environ;
+
+#define DEFAULT_ITERATIONS 200
+
+static const char *program = "/bin/true";
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static pid_t launch_fork(void) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        char *argv[] = {(char *)program, NULL};
+        execv(program, argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t launch_spawn(void) {
+    pid_t pid;
+    char *argv[] = {(char *)program, NULL};
+    if (posix_spawn(&pid, program, NULL, NULL, argv, environ) != 0) return -1;
+    return pid;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Time one launcher; the figure is launch until the parent regains
+ * control, plus waiting for the child, as a pipeline stage would see it
+ */
+static void measure(const char *name, pid_t (*launch)(void), int iterations, double *samples) {
+    for (int i = 0; i < iterations; i++) {
+        double start = now_us();
+        pid_t pid = launch();
+        if (pid < 0) {
+            perror(name);
+            exit(1);
+        }
+        waitpid(pid, NULL, 0);
+        samples[i] = now_us() - start;
+    }
+    qsort(samples, iterations, sizeof(double), compare_double);
+    printf("  %-12s median %8.1f us   p90 %8.1f us\n",
+           name, samples[iterations / 2], samples[iterations * 9 / 10]);
+}
+
+static long rss_mb(void) {
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+int main(int argc, char **argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') iterations = atoi(optarg);
+        else {
+            fprintf(stderr, "Usage: %s [-n iterations] [ballast MB ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    long default_sizes[] = {0, 64, 256, 1024};
+    int num_sizes = argc - optind;
+    long *sizes = num_sizes > 0 ? malloc(num_sizes * sizeof(long)) : default_sizes;
+    if (num_sizes > 0) {
+        for (int i = 0; i < num_sizes; i++) sizes[i] = atol(argv[optind + i]);
+    } else {
+        num_sizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    }
+
+    double *samples = malloc(iterations * sizeof(double));
+    char *ballast = NULL;
+    for (int s = 0; s < num_sizes; s++) {
+        free(ballast);
+        size_t bytes = (size_t)sizes[s] * 1024 * 1024;
+        ballast = bytes ? malloc(bytes) : NULL;
+        if (bytes && !ballast) {
+            fprintf(stderr, "Cannot allocate %ld MB ballast\n", sizes[s]);
+            break;
+        }
+        // Touch every page so it is resident and fork has to copy its mapping
+        if (ballast) memset(ballast, 1, bytes);
+
+        printf("ballast %ld MB (RSS %ld MB), %d launches of %s\n",
+               sizes[s], rss_mb(), iterations, program);
+        measure("fork+exec", launch_fork, iterations, samples);
+        measure("posix_spawn", launch_spawn, iterations, samples);
+    }
+
+    free(ballast);
+    free(samples);
+    if (sizes != default_sizes) free(sizes);
+    return 0;
+}
@@ -5,7 +5,12 @@
 #include <readline/readline.h>
 #include "visionos.h"
 
-int handle_builtin(char **args) {
+/**
+ * Run args if it is a builtin. Returns 1 if it was; its exit status is
+ * stored in *status.
+ */
+int handle_builtin(char **args, int *status) {
+    *status = 0;
     if (args[0] == NULL) return 0;
 
     if (strcmp(args[0], "exit") == 0) {
@@ -31,9 +36,33 @@ int handle_builtin(char **args) {
         return 1;
     }
 
+    if (strcmp(args[0], "cache-stats") == 0) {
+        print_cache_stats();
+        return 1;
+    }
+
+    if (strcmp(args[0], "cache-clear") == 0) {
+        clear_image_cache();
+        printf("Image cache cleared.\n");
+        return 1;
+    }
+
+    if (strcmp(args[0], "sysmon") == 0) {
+        *status = run_sysmon(args);
+        return 1;
+    }
+
+    if (strcmp(args[0], "vhash") == 0) {
+        *status = run_vhash(args);
+        return 1;
+    }
+
     if (strcmp(args[0], "cd") == 0) {
         char *path = args[1] ? args[1] : getenv("HOME");
-        if (chdir(path) != 0) perror("cd failed");
+        if (chdir(path) != 0) {
+            perror("cd failed");
+            *status = 1;
+        }
         return 1;
     }
 
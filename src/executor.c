@@ -3,8 +3,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <spawn.h>
+#include <sys/stat.h>
 #include "visionos.h"
 
+extern char **environ;
+
 static int is_cv_command(const char *cmd) { 
     return strncmp(cmd, CV_PREFIX, strlen(CV_PREFIX)) == 0; 
 }
@@ -15,10 +20,40 @@ static int is_vls_command(const char *cmd) {
     return strcmp(cmd, "vls") == 0; 
 }
 
-void handle_redirection(char **args) {
+/**
+ * Could the child open path for writing? An existing file must be
+ * writable, a new one needs a writable parent directory. Sets errno.
+ */
+static int output_writable(const char *path) {
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) {
+            errno = EISDIR;
+            return 0;
+        }
+        return access(path, W_OK) == 0;
+    }
+    if (errno != ENOENT) return 0;
+
+    char dir[1024];
+    const char *slash = strrchr(path, '/');
+    if (!slash) return access(".", W_OK) == 0;
+    size_t len = slash == path ? 1 : (size_t)(slash - path);
+    if (len >= sizeof(dir)) len = sizeof(dir) - 1;
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+    return access(dir, W_OK) == 0;
+}
+
+/**
+ * Turn '>', '>>' and '<' into open file actions for the child and remove
+ * them from args. Returns 0 on a syntax error or a redirection target that
+ * cannot be opened, which is checked here so the error names the file,
+ * not the command.
+ */
+static int add_redirections(char **args, posix_spawn_file_actions_t *actions) {
     int i = 0;
     while (args[i] != NULL) {
-        int fd = -1;
         RedirectType redirect_type = REDIRECT_NONE;
 
         if (strcmp(args[i], ">") == 0) redirect_type = REDIRECT_OVERWRITE;
@@ -28,25 +63,27 @@ void handle_redirection(char **args) {
         if (redirect_type != REDIRECT_NONE) {
             if (args[i+1] == NULL) {
                 fprintf(stderr, "Syntax error: expected file after redirection\n");
-                exit(1);
+                return 0;
             }
             
+            if (redirect_type != REDIRECT_INPUT && !output_writable(args[i+1])) {
+                fprintf(stderr, "Cannot open output file %s: %s\n", args[i+1], strerror(errno));
+                return 0;
+            }
+
             if (redirect_type == REDIRECT_OVERWRITE) {
-                fd = open(args[i+1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                dup2(fd, STDOUT_FILENO);
+                posix_spawn_file_actions_addopen(actions, STDOUT_FILENO, args[i+1],
+                                                 O_WRONLY | O_CREAT | O_TRUNC, 0644);
             } else if (redirect_type == REDIRECT_APPEND) {
-                fd = open(args[i+1], O_WRONLY | O_CREAT | O_APPEND, 0644);
-                dup2(fd, STDOUT_FILENO);
+                posix_spawn_file_actions_addopen(actions, STDOUT_FILENO, args[i+1],
+                                                 O_WRONLY | O_CREAT | O_APPEND, 0644);
             } else if (redirect_type == REDIRECT_INPUT) {
-                fd = open(args[i+1], O_RDONLY);
-                dup2(fd, STDIN_FILENO);
-            }
-            
-            if (fd < 0) {
-                perror("open failed");
-                exit(1);
+                if (access(args[i+1], R_OK) != 0) {
+                    fprintf(stderr, "Cannot open input file %s: %s\n", args[i+1], strerror(errno));
+                    return 0;
+                }
+                posix_spawn_file_actions_addopen(actions, STDIN_FILENO, args[i+1], O_RDONLY, 0);
             }
-            close(fd);
 
             // Shift arguments: remove args[i] and args[i+1]
             int j = i;
@@ -60,55 +97,77 @@ void handle_redirection(char **args) {
             i++;
         }
     }
+    return 1;
 }
 
-void execute_command(char **args) {
-    if (args[0] == NULL) exit(0);
-
-    handle_redirection(args);
-
+/**
+ * Build the argv that runs a command: cv-* and vls through python3,
+ * sh-* through bash, anything else as-is
+ */
+static char **build_argv(char **args, char **argv, char *script_path, size_t size) {
     char apps_path[1024];
     get_apps_path(apps_path, sizeof(apps_path));
-    char script_path[2048];
 
     if (is_cv_command(args[0])) {
         const char *cv_cmd = args[0] + strlen(CV_PREFIX);
-        snprintf(script_path, sizeof(script_path), "%s/cv_%s.py", apps_path, cv_cmd);
-        
-        char *py_args[MAX_ARGS + 2];
-        py_args[0] = "python3";
-        py_args[1] = script_path;
-        int i = 1;
-        while (args[i] != NULL) { py_args[i + 1] = args[i]; i++; }
-        py_args[i + 1] = NULL;
-        execvp("python3", py_args);
-
+        snprintf(script_path, size, "%s/cv_%s.py", apps_path, cv_cmd);
+        argv[0] = "python3";
     } else if (is_vls_command(args[0])) {
-        snprintf(script_path, sizeof(script_path), "%s/vls.py", apps_path);
-        char *py_args[MAX_ARGS + 2];
-        py_args[0] = "python3";
-        py_args[1] = script_path;
-        int i = 1;
-        while (args[i] != NULL) { py_args[i + 1] = args[i]; i++; }
-        py_args[i + 1] = NULL;
-        execvp("python3", py_args);
-
+        snprintf(script_path, size, "%s/vls.py", apps_path);
+        argv[0] = "python3";
     } else if (is_sh_command(args[0])) {
         const char *sh_cmd = args[0] + strlen(SH_PREFIX);
         // Using apps_path logic for consistency
-        snprintf(script_path, sizeof(script_path), "%s/../bash_scripts/sh_%s.sh", apps_path, sh_cmd);
-        char *sh_args[MAX_ARGS + 2];
-        sh_args[0] = "bash";
-        sh_args[1] = script_path;
-        int i = 1;
-        while (args[i] != NULL) { sh_args[i + 1] = args[i]; i++; }
-        sh_args[i + 1] = NULL;
-        execvp("bash", sh_args);
-
+        snprintf(script_path, size, "%s/../bash_scripts/sh_%s.sh", apps_path, sh_cmd);
+        argv[0] = "bash";
     } else {
-        execvp(args[0], args);
+        return args;
     }
 
-    perror("Execution failed");
-    exit(1);
-}
\ No newline at end of file
+    argv[1] = script_path;
+    int i = 1;
+    while (args[i] != NULL) { argv[i + 1] = args[i]; i++; }
+    argv[i + 1] = NULL;
+    return argv;
+}
+
+/**
+ * Launch one pipeline stage without duplicating the shell. posix_spawn
+ * (CLONE_VM|CLONE_VFORK in glibc) costs the same whatever our RSS, where
+ * fork() copies the page tables of every cache and history buffer first.
+ * in_fd/out_fd are pipe ends for stdin/stdout, or -1 to inherit ours;
+ * redirections in args are applied after them. The child starts with
+ * sigmask and envp (environ if NULL). Returns the pid, or -1.
+ */
+pid_t spawn_command(char **args, int in_fd, int out_fd, const sigset_t *sigmask, char **envp) {
+    if (args[0] == NULL) return -1;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    if (in_fd != -1) posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    if (out_fd != -1) posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+
+    pid_t pid = -1;
+    if (add_redirections(args, &actions)) {
+        posix_spawnattr_setsigmask(&attr, sigmask);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+        char *argv[MAX_ARGS + 2];
+        char script_path[2048];
+        char **exec_args = build_argv(args, argv, script_path, sizeof(script_path));
+
+        int err = posix_spawnp(&pid, exec_args[0], &actions, &attr, exec_args,
+                               envp ? envp : environ);
+        if (err != 0) {
+            fprintf(stderr, "Execution failed: %s: %s\n", args[0], strerror(err));
+            pid = -1;
+        }
+    }
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
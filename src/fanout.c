@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include "visionos.h"
+
+// Fan-out pipelines: "UPSTREAM |& { BRANCH ; BRANCH ; ... }".
+// The upstream writes raw frames into one pipe and the shell copies that
+// stream into a pipe per branch, so the input is decoded once and every
+// branch runs concurrently on the same pixels.
+
+#define FANOUT_CHUNK (1 << 20)
+#define FANOUT_PIPE_SIZE (1 << 20)
+
+/**
+ * Split "UPSTREAM |& { A ; B ; C }" in place: input is cut at the
+ * operator and the branch texts are stored in branches[]. Returns the
+ * number of branches, 0 if the line has no fan-out, or -1 on a syntax error.
+ */
+int split_fanout(char *input, char **branches, int max_branches) {
+    char *op = strstr(input, "|&");
+    if (!op) return 0;
+    *op = '\0';
+
+    char *open = op + 2;
+    while (*open == ' ' || *open == '\t') open++;
+    char *close = strrchr(open, '}');
+    if (*open != '{' || !close) {
+        fprintf(stderr, "Syntax error: expected '{ cmd ; cmd ... }' after '|&'\n");
+        return -1;
+    }
+    for (char *p = close + 1; *p; p++) {
+        if (*p != ' ' && *p != '\t' && *p != '\n') {
+            fprintf(stderr, "Syntax error: unexpected text after '}'\n");
+            return -1;
+        }
+    }
+    *close = '\0';
+
+    int count = 0;
+    char *ptr = open + 1, *branch;
+    while ((branch = strsep(&ptr, ";")) != NULL) {
+        if (strspn(branch, " \t\n") == strlen(branch)) continue;
+        if (count == max_branches) {
+            fprintf(stderr, "Syntax error: at most %d fan-out branches\n", max_branches);
+            return -1;
+        }
+        branches[count++] = branch;
+    }
+    if (count == 0) {
+        fprintf(stderr, "Syntax error: empty fan-out\n");
+        return -1;
+    }
+    return count;
+}
+
+static void drop_branch(int *outs, int i, int *live) {
+    close(outs[i]);
+    outs[i] = -1;
+    (*live)--;
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 1;
+}
+
+/**
+ * Copy everything from in_fd to every branch pipe in outs, then close them.
+ * tee(2) duplicates the data into the branch pipes without copying it
+ * through the shell. The chunk is then read once to take it off the input,
+ * and that copy fills in any branch whose pipe was too full for the whole
+ * chunk. A branch that exits early is dropped; the others keep running.
+ */
+void pump_fanout(int in_fd, int *outs, int n) {
+    struct sigaction ignore, old;
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    ignore.sa_flags = 0;
+    sigaction(SIGPIPE, &ignore, &old);
+
+    // Larger pipes let fast branches run ahead of slow ones by a few frames
+    fcntl(in_fd, F_SETPIPE_SZ, FANOUT_PIPE_SIZE);
+    for (int i = 0; i < n; i++) fcntl(outs[i], F_SETPIPE_SZ, FANOUT_PIPE_SIZE);
+
+    char *buf = malloc(FANOUT_CHUNK);
+    ssize_t *sent = calloc(n, sizeof(ssize_t));
+    int live = n;
+
+    while (live > 0 && buf && sent) {
+        ssize_t chunk = -1;
+        for (int i = 0; i < n; i++) {
+            if (outs[i] < 0) continue;
+            ssize_t r = tee(in_fd, outs[i], chunk < 0 ? FANOUT_CHUNK : (size_t)chunk, 0);
+            if (r < 0 && errno == EINTR) {
+                i--;
+                continue;
+            }
+            if (r < 0) {
+                drop_branch(outs, i, &live);
+                continue;
+            }
+            if (chunk < 0) {
+                if (r == 0) goto done;  // upstream finished
+                chunk = r;
+            }
+            sent[i] = r;
+        }
+        if (chunk < 0) break;
+
+        ssize_t got = 0;
+        while (got < chunk) {
+            ssize_t r = read(in_fd, buf + got, chunk - got);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) goto done;
+            got += r;
+        }
+        for (int i = 0; i < n; i++) {
+            if (outs[i] < 0 || sent[i] == chunk) continue;
+            if (!write_all(outs[i], buf + sent[i], chunk - sent[i])) drop_branch(outs, i, &live);
+        }
+    }
+
+done:
+    for (int i = 0; i < n; i++) {
+        if (outs[i] >= 0) close(outs[i]);
+    }
+    free(sent);
+    free(buf);
+    sigaction(SIGPIPE, &old, NULL);
+}
@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "visionos.h"
+
+// File fingerprints: a 64-bit content digest per file, kept in a persistent
+// table keyed by (dev, inode, size, mtime_ns) so unchanged files are never
+// read again. Files are read with pread() and hashed with XXH64 in 4 MiB
+// chunks on several threads, each with its own buffer; a mapping would
+// SIGBUS the shell if a file were truncated while it is hashed. The digest
+// of a larger file is the XXH64 of its chunk digests, seeded with the file
+// size. Files of one chunk or less get their plain XXH64.
+//
+// The table is an append-only file of fixed records after an 8-byte magic,
+// shared with apps/fingerprint.py:
+//   uint64 dev, uint64 ino, uint64 size, int64 mtime_ns, uint64 digest
+
+#define FP_MAGIC "VOSFP001"
+#define FP_CHUNK (4u << 20)
+#define FP_MAX_THREADS 8
+#define FP_COMPACT_SLACK 4096        // stale records tolerated before a rewrite
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t digest;
+} FpRecord;
+
+static FpRecord *table = NULL;       // open addressing on (dev, ino)
+static size_t table_capacity = 0;
+static size_t table_count = 0;
+static off_t table_loaded = 0;       // bytes of the table file already read
+static ino_t table_ino = 0;          // compaction replaces the file
+
+// ---------------------------------------------------------------- XXH64
+
+#define PRIME64_1 11400714785074694791ULL
+#define PRIME64_2 14029467366897019727ULL
+#define PRIME64_3 1609587929392839161ULL
+#define PRIME64_4 9650029242287828579ULL
+#define PRIME64_5 2870177450012600261ULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));   // little-endian hosts
+    return v;
+}
+
+static inline uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static uint64_t xxh64(const void *data, size_t len, uint64_t seed) {
+    const unsigned char *p = data;
+    const unsigned char *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        const unsigned char *limit = end - 32;
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h ^= xxh_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// ------------------------------------------------------- parallel hashing
+
+typedef struct {
+    int fd;
+    size_t size;
+    size_t num_chunks;
+    uint64_t *digests;
+    int first;
+    int stride;
+    int failed;
+} ChunkJob;
+
+/**
+ * Read exactly len bytes at offset; a short read means the file shrank
+ */
+static int read_chunk(int fd, unsigned char *buf, size_t len, off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, buf + done, len - done, offset + (off_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static void *hash_chunks(void *arg) {
+    ChunkJob *job = arg;
+    size_t capacity = job->size < FP_CHUNK ? job->size : FP_CHUNK;
+    unsigned char *buf = malloc(capacity ? capacity : 1);
+    if (!buf) {
+        job->failed = 1;
+        return NULL;
+    }
+    for (size_t i = job->first; i < job->num_chunks && !job->failed; i += job->stride) {
+        size_t offset = i * FP_CHUNK;
+        size_t len = job->size - offset < FP_CHUNK ? job->size - offset : FP_CHUNK;
+        if (read_chunk(job->fd, buf, len, (off_t)offset) != 0) job->failed = 1;
+        else job->digests[i] = xxh64(buf, len, 0);
+    }
+    free(buf);
+    return NULL;
+}
+
+/**
+ * Digest of the first size bytes of fd. Returns 0 on success, -1 if the
+ * file could not be read in full or memory ran out.
+ */
+static int hash_fd(int fd, size_t size, uint64_t *digest) {
+    size_t num_chunks = (size + FP_CHUNK - 1) / FP_CHUNK;
+    if (num_chunks <= 1) {
+        ChunkJob job = {fd, size, 1, digest, 0, 1, 0};
+        hash_chunks(&job);
+        return job.failed ? -1 : 0;
+    }
+
+    uint64_t *digests = malloc(num_chunks * sizeof(uint64_t));
+    if (!digests) return -1;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    if (threads > FP_MAX_THREADS) threads = FP_MAX_THREADS;
+    if ((size_t)threads > num_chunks) threads = (int)num_chunks;
+
+    pthread_t tids[FP_MAX_THREADS];
+    ChunkJob jobs[FP_MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = (ChunkJob){fd, size, num_chunks, digests, t, threads, 0};
+        // Thread 0's share is hashed on this thread
+        if (t > 0 && pthread_create(&tids[t], NULL, hash_chunks, &jobs[t]) == 0) started |= 1 << t;
+        else if (t > 0) hash_chunks(&jobs[t]);
+    }
+    hash_chunks(&jobs[0]);
+    int failed = jobs[0].failed;
+    for (int t = 1; t < threads; t++) {
+        if (started & (1 << t)) pthread_join(tids[t], NULL);
+        failed |= jobs[t].failed;
+    }
+
+    if (!failed) *digest = xxh64(digests, num_chunks * sizeof(uint64_t), size);
+    free(digests);
+    return failed ? -1 : 0;
+}
+
+static int hash_file(const char *path, const struct stat *st, uint64_t *digest) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    int status = hash_fd(fd, st->st_size, digest);
+    close(fd);
+    return status;
+}
+
+// ------------------------------------------------------- persistent table
+
+static const char *table_path(void) {
+    static char path[1024];
+    const char *env = getenv("VISIONOS_FP_TABLE");
+    if (env && *env) return env;
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (xdg && *xdg) snprintf(path, sizeof(path), "%s/visionos/fingerprints", xdg);
+    else snprintf(path, sizeof(path), "%s/.cache/visionos/fingerprints", home ? home : "/tmp");
+    return path;
+}
+
+static void make_parent_dirs(const char *path) {
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", path);
+    for (char *p = dir + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        mkdir(dir, 0755);
+        *p = '/';
+    }
+}
+
+static size_t slot_for(uint64_t dev, uint64_t ino) {
+    uint64_t h = (dev * PRIME64_1) ^ (ino * PRIME64_2);
+    return (size_t)(h ^ (h >> 29)) & (table_capacity - 1);
+}
+
+static void table_put(const FpRecord *rec) {
+    if ((table_count + 1) * 2 > table_capacity) {
+        size_t old_capacity = table_capacity;
+        FpRecord *old = table;
+        size_t capacity = old_capacity ? old_capacity * 2 : 1024;
+        FpRecord *grown = calloc(capacity, sizeof(FpRecord));
+        if (!grown) return;
+        table = grown;
+        table_capacity = capacity;
+        table_count = 0;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].size || old[i].ino) table_put(&old[i]);
+        }
+        free(old);
+    }
+
+    size_t i = slot_for(rec->dev, rec->ino);
+    while (table[i].size || table[i].ino) {
+        if (table[i].dev == rec->dev && table[i].ino == rec->ino) {
+            table[i] = *rec;   // later records replace earlier ones
+            return;
+        }
+        i = (i + 1) & (table_capacity - 1);
+    }
+    table[i] = *rec;
+    table_count++;
+}
+
+static const FpRecord *table_get(uint64_t dev, uint64_t ino) {
+    if (!table) return NULL;
+    size_t i = slot_for(dev, ino);
+    while (table[i].size || table[i].ino) {
+        if (table[i].dev == dev && table[i].ino == ino) return &table[i];
+        i = (i + 1) & (table_capacity - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Rewrite the table with one record per file once stale records (files
+ * that changed since) dominate. Records appended by others meanwhile may
+ * be lost; those files are simply hashed again.
+ */
+static void compact_table(void) {
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.%d", table_path(), (int)getpid());
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return;
+    fwrite(FP_MAGIC, 1, 8, f);
+    for (size_t i = 0; i < table_capacity; i++) {
+        if (table[i].size || table[i].ino) fwrite(&table[i], sizeof(FpRecord), 1, f);
+    }
+    if (fclose(f) != 0 || rename(tmp, table_path()) != 0) {
+        unlink(tmp);
+        return;
+    }
+    table_loaded = 0;   // picked up again, inode and all, by the next sync
+}
+
+/**
+ * Read records appended since the last call, by us or by other processes
+ */
+static void sync_table(void) {
+    int fd = open(table_path(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_ino != table_ino || st.st_size < table_loaded) table_loaded = 0;
+    if (table_loaded == 0) {
+        char magic[8];
+        if (read(fd, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, FP_MAGIC, 8) != 0) {
+            close(fd);
+            return;
+        }
+        table_loaded = sizeof(magic);
+        table_ino = st.st_ino;
+    }
+
+    FpRecord batch[256];
+    ssize_t n;
+    lseek(fd, table_loaded, SEEK_SET);
+    while ((n = read(fd, batch, sizeof(batch))) >= (ssize_t)sizeof(FpRecord)) {
+        size_t records = n / sizeof(FpRecord);
+        for (size_t i = 0; i < records; i++) table_put(&batch[i]);
+        table_loaded += records * sizeof(FpRecord);
+        lseek(fd, table_loaded, SEEK_SET);
+    }
+    close(fd);
+
+    size_t on_disk = (table_loaded - 8) / sizeof(FpRecord);
+    if (on_disk > 2 * table_count + FP_COMPACT_SLACK) compact_table();
+}
+
+/**
+ * Append one record; a single small O_APPEND write does not interleave
+ * with other writers
+ */
+static void append_record(const FpRecord *rec) {
+    const char *path = table_path();
+    int fd = open(path, O_WRONLY | O_APPEND);
+    if (fd < 0 && errno == ENOENT) {
+        make_parent_dirs(path);
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+        if (fd >= 0 && write(fd, FP_MAGIC, 8) != 8) {
+            close(fd);
+            return;
+        }
+        if (fd < 0) fd = open(path, O_WRONLY | O_APPEND);   // lost the race
+    }
+    if (fd < 0) return;
+    if (write(fd, rec, sizeof(*rec)) != (ssize_t)sizeof(*rec)) perror("vhash: table write failed");
+    close(fd);
+}
+
+/**
+ * Digest of a file's content, from the table when its (dev, inode, size,
+ * mtime) are unchanged. Returns 0 on success; *cached tells which path
+ * was taken.
+ */
+int fingerprint_file(const char *path, uint64_t *digest, int *cached) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+    int64_t mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+    sync_table();
+    const FpRecord *hit = table_get(st.st_dev, st.st_ino);
+    if (hit && hit->size == (uint64_t)st.st_size && hit->mtime_ns == mtime_ns) {
+        *digest = hit->digest;
+        *cached = 1;
+        return 0;
+    }
+
+    if (hash_file(path, &st, digest) != 0) return -1;
+    *cached = 0;
+    FpRecord rec = {st.st_dev, st.st_ino, st.st_size, mtime_ns, *digest};
+    table_put(&rec);
+    append_record(&rec);
+    return 0;
+}
+
+static int by_name(const struct dirent **a, const struct dirent **b) {
+    return strcmp((*a)->d_name, (*b)->d_name);
+}
+
+/**
+ * vhash [-v] path...   Print "digest  path" for files and for the files
+ * directly inside directories. -v adds cache/throughput statistics.
+ * Returns 0 if every file could be hashed.
+ */
+int run_vhash(char **args) {
+    int verbose = 0, status = 0;
+    int files = 0, cached_files = 0;
+    double hashed_bytes = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 1; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-v") == 0) {
+            verbose = 1;
+            continue;
+        }
+
+        struct stat st;
+        if (stat(args[i], &st) != 0) {
+            fprintf(stderr, "vhash: %s: %s\n", args[i], strerror(errno));
+            status = 1;
+            continue;
+        }
+
+        struct dirent **entries = NULL;
+        int count = 1;
+        if (S_ISDIR(st.st_mode)) {
+            count = scandir(args[i], &entries, NULL, by_name);
+            if (count < 0) count = 0;
+        }
+        for (int e = 0; e < count; e++) {
+            char path[2048];
+            if (entries) snprintf(path, sizeof(path), "%s/%s", args[i], entries[e]->d_name);
+            else snprintf(path, sizeof(path), "%s", args[i]);
+            if (entries) {
+                free(entries[e]);
+                struct stat est;
+                if (stat(path, &est) != 0 || !S_ISREG(est.st_mode)) continue;
+            }
+
+            uint64_t digest;
+            int cached;
+            if (fingerprint_file(path, &digest, &cached) != 0) {
+                fprintf(stderr, "vhash: %s: cannot hash\n", path);
+                status = 1;
+                continue;
+            }
+            printf("%016llx  %s\n", (unsigned long long)digest, path);
+            files++;
+            if (cached) {
+                cached_files++;
+            } else {
+                struct stat hst;
+                if (stat(path, &hst) == 0) hashed_bytes += hst.st_size;
+            }
+        }
+        free(entries);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fflush(stdout);
+    if (verbose) {
+        double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        double mb = hashed_bytes / (1024.0 * 1024.0);
+        fprintf(stderr, "%d files: %d from table, %d hashed (%.1f MB, %.0f MB/s) in %.3f s\n",
+                files, cached_files, files - cached_files, mb, secs > 0 ? mb / secs : 0.0, secs);
+        fprintf(stderr, "Table: %s (%zu files)\n", table_path(), table_count);
+    }
+    return status;
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "visionos.h"
+
+/**
+ * Directory holding this user's decoded-image cache (see apps/cv_utils.py)
+ */
+static const char *image_cache_dir(void) {
+    static char path[256];
+    const char *dir = getenv("VISIONOS_CACHE_DIR");
+    if (dir && *dir) return dir;
+    snprintf(path, sizeof(path), "%s-%d", IMG_CACHE_DIR, (int)getuid());
+    return path;
+}
+
+/**
+ * Hit and miss counters kept by the Python apps: three little-endian
+ * int64 (hits, misses, estimated bytes) in the "stats" file
+ */
+static void read_counters(const char *dir, long *hits, long *misses) {
+    char path[1024];
+    long long counters[3] = {0, 0, 0};
+    snprintf(path, sizeof(path), "%s/stats", dir);
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        if (fread(counters, sizeof(counters), 1, f) != 1) counters[0] = counters[1] = 0;
+        fclose(f);
+    }
+    *hits = (long)counters[0];
+    *misses = (long)counters[1];
+}
+
+/**
+ * Show hit rate and resident size of the decoded-image cache
+ */
+void print_cache_stats(void) {
+    const char *dir = image_cache_dir();
+    DIR *d = opendir(dir);
+    size_t resident = 0;
+    int entries = 0;
+
+    if (d) {
+        struct dirent *entry;
+        char path[1024];
+        struct stat st;
+        while ((entry = readdir(d))) {
+            size_t len = strlen(entry->d_name);
+            if (len < 4 || strcmp(entry->d_name + len - 4, ".npy") != 0) continue;
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            if (stat(path, &st) == 0) {
+                resident += (size_t)st.st_size;
+                entries++;
+            }
+        }
+        closedir(d);
+    }
+
+    long hits, misses;
+    read_counters(dir, &hits, &misses);
+    long lookups = hits + misses;
+
+    printf("\n=== Image Cache ===\n");
+    printf("Directory: %s\n", dir);
+    printf("Cached images: %d\n", entries);
+    printf("Resident bytes: %zu (%.1f MiB)\n", resident, resident / (1024.0 * 1024.0));
+    printf("Hits: %ld  Misses: %ld\n", hits, misses);
+    if (lookups > 0) {
+        printf("Hit rate: %.1f%%\n", 100.0 * hits / lookups);
+    } else {
+        printf("Hit rate: n/a\n");
+    }
+    printf("===================\n\n");
+}
+
+/**
+ * Drop every cached image and reset the counters
+ */
+void clear_image_cache(void) {
+    const char *dir = image_cache_dir();
+    DIR *d = opendir(dir);
+    if (!d) return;
+
+    struct dirent *entry;
+    char path[1024];
+    while ((entry = readdir(d))) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        unlink(path);
+    }
+    closedir(d);
+}
@@ -1,32 +1,218 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 #include "visionos.h"
 
-int main() {
+typedef struct {
+    pid_t pids[MAX_ARGS];
+    int terminal[MAX_ARGS];  // last stage of the line or of a fan-out branch
+    int num_pids;
+    int failed;              // a terminal stage could not be started
+} Job;
+
+/**
+ * Spawn a linear pipeline. in_fd feeds its first stage and out_fd takes the
+ * last stage's output (-1: the shell's own); both stay owned by the caller.
+ */
+static void spawn_pipeline(char ***stages, ThreadBudget *budgets, int n, int in_fd, int out_fd,
+                           int terminal, const sigset_t *mask, Job *job) {
+    int pipefd[2];
+    int prev_pipe_read = in_fd;
+
+    for (int i = 0; i < n; i++) {
+        char **args = stages[i];
+        if (args[0] == NULL) continue;
+
+        // Close-on-exec: a child only keeps the ends placed on its stdin/stdout
+        int stage_out = out_fd;
+        if (i < n - 1) {
+            pipe2(pipefd, O_CLOEXEC);
+            stage_out = pipefd[1];
+        }
+
+        char **env = budget_env(&budgets[i]);
+        pin_for_stage(&budgets[i]);
+        pid_t pid = spawn_command(args, prev_pipe_read, stage_out, mask, env);
+        restore_shell_affinity();
+        free_budget_env(env);
+
+        if (pid > 0) {
+            job->pids[job->num_pids] = pid;
+            job->terminal[job->num_pids++] = terminal && i == n - 1;
+            set_foreground_pid(pid);
+        } else if (terminal && i == n - 1) {
+            job->failed = 1;
+        }
+        if (prev_pipe_read != -1 && prev_pipe_read != in_fd) close(prev_pipe_read);
+        prev_pipe_read = -1;
+        if (i < n - 1) {
+            prev_pipe_read = pipefd[0];
+            close(pipefd[1]);
+        }
+    }
+}
+
+/**
+ * Run the branches of "UPSTREAM |& { A ; B ; ... }": the upstream's raw
+ * frames are copied to every branch while all of them run.
+ */
+static void spawn_fanout(char ***stages, ThreadBudget *budgets, const int *seg_first,
+                         int num_branches, const sigset_t *mask, Job *job) {
+    int fan[2];
+    pipe2(fan, O_CLOEXEC);
+
+    // Raw frames instead of PNG: the branches read them without decoding
+    char *saved = getenv("VISIONOS_ENCODE") ? safe_strdup(getenv("VISIONOS_ENCODE")) : NULL;
+    setenv("VISIONOS_ENCODE", "fast", 1);
+    spawn_pipeline(stages, budgets, seg_first[1], -1, fan[1], 0, mask, job);
+    if (saved) setenv("VISIONOS_ENCODE", saved, 1);
+    else unsetenv("VISIONOS_ENCODE");
+    free(saved);
+    close(fan[1]);
+
+    int outs[MAX_FANOUT];
+    for (int b = 0; b < num_branches; b++) {
+        int branch[2];
+        pipe2(branch, O_CLOEXEC);
+        int first = seg_first[b + 1];
+        spawn_pipeline(stages + first, budgets + first, seg_first[b + 2] - first,
+                       branch[0], -1, 1, mask, job);
+        close(branch[0]);
+        outs[b] = branch[1];
+    }
+
+    pump_fanout(fan[0], outs, num_branches);
+    close(fan[0]);
+}
+
+/**
+ * Run one input line: a single command, a '|' pipeline or a '|&' fan-out.
+ * Returns the exit status of the last stage, or of the first failing
+ * branch of a fan-out (0 for builtins).
+ */
+int run_command_line(char *input) {
+    // Segment 0 is the (upstream) pipeline, the others are fan-out branches
+    char *segments[MAX_FANOUT + 1];
+    int num_branches = split_fanout(input, segments + 1, MAX_FANOUT);
+    if (num_branches < 0) return 2;
+    segments[0] = input;
+
+    char *commands[MAX_ARGS];
+    int seg_first[MAX_FANOUT + 2];
+    int num_cmds = 0;
+    for (int s = 0; s <= num_branches; s++) {
+        char *cmd_ptr = segments[s];
+        char *temp_cmd;
+        seg_first[s] = num_cmds;
+        while ((temp_cmd = strsep(&cmd_ptr, "|")) != NULL && num_cmds < MAX_ARGS) {
+            if (*temp_cmd != '\0') commands[num_cmds++] = temp_cmd;
+        }
+    }
+    seg_first[num_branches + 1] = num_cmds;
+
+    // Parse every stage first so CPUs can be split between them
+    char *stage_args[MAX_ARGS][MAX_ARGS];
+    char **stages[MAX_ARGS];
+    ThreadBudget budgets[MAX_ARGS];
+    for (int i = 0; i < num_cmds; i++) {
+        parse_input(commands[i], stage_args[i]);
+        stages[i] = stage_args[i];
+    }
+    plan_thread_budgets(stages, num_cmds, budgets);
+
+    // Handle Built-ins
+    int builtin_status;
+    if (num_cmds == 1 && num_branches == 0 && handle_builtin(stages[0], &builtin_status)) {
+        return builtin_status;
+    }
+
+    // Keep SIGCHLD from reaping our children before we collect their status
+    sigset_t block, old_mask;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &old_mask);
+
+    Job job = {0};
+    if (num_branches == 0) {
+        spawn_pipeline(stages, budgets, num_cmds, -1, -1, 1, &old_mask, &job);
+    } else {
+        spawn_fanout(stages, budgets, seg_first, num_branches, &old_mask, &job);
+    }
+
+    int status = 0;
+    for (int i = 0; i < job.num_pids; i++) {
+        int wstatus;
+        if (waitpid(job.pids[i], &wstatus, 0) != job.pids[i] || !job.terminal[i]) continue;
+        int code = 0;
+        if (WIFEXITED(wstatus)) code = WEXITSTATUS(wstatus);
+        else if (WIFSIGNALED(wstatus)) code = 128 + WTERMSIG(wstatus);
+        if (status == 0) status = code;
+    }
+    if (job.failed && status == 0) status = 1;
+    set_foreground_pid(-1);
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+    return status;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-f script.vos [-j jobs]]\n", prog);
+    fprintf(stderr, "       %s --vhash [-v] path...\n", prog);
+}
+
+int main(int argc, char **argv) {
     char *input;
+    const char *script_path = NULL;
+    int jobs = 1;
+
+    // Fingerprint lookup for the Python apps, without starting a shell
+    if (argc > 1 && strcmp(argv[1], "--vhash") == 0) {
+        return run_vhash(argv + 1);
+    }
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:j:h")) != -1) {
+        switch (opt) {
+            case 'f': script_path = optarg; break;
+            case 'j': jobs = atoi(optarg); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+
     setup_signals();
+
+    // Batch mode: no prompt and no inactivity timeout
+    if (script_path) {
+        return run_script(script_path, jobs > 0 ? jobs : 1);
+    }
+
     printf("VisionOS Shell Initiated (with Memory Management).\n");
-    printf("Built-in commands: history, clear-history, mem-stats, exit\n");
+    printf("Built-in commands: history, clear-history, mem-stats, cache-stats, cache-clear, sysmon, vhash, exit\n");
     printf("====================================\n\n");
 
 
     setup_shell();
-    
+    setup_predictor();
+
     // Allow our signals to propagate even when readline is active
     rl_catch_signals = 0;
 
     while (1) {
+        // Warm up for the likely next command while the user types
+        prewarm_predicted();
+
         alarm(TIMEOUT_SECONDS);
         input = readline("visionos> ");
         alarm(0);
-        
+
         if (!input) break; // EOF
-        
+
         if (strlen(input) > 0) {
             add_history(input);
             add_to_history(input); // Keep our custom memory management in sync
@@ -34,56 +220,12 @@ int main() {
             free(input);
             continue;
         }
-        
-        char *commands[MAX_ARGS];
-        int num_cmds = 0;
-        char *cmd_ptr = input;
-        char *temp_cmd;
 
-        while ((temp_cmd = strsep(&cmd_ptr, "|")) != NULL && num_cmds < MAX_ARGS) {
-            if (*temp_cmd != '\0') commands[num_cmds++] = temp_cmd;
-        }
+        predict_command_started();
+        run_command_line(input);
+        predict_command_finished();
 
-        int pipefd[2];
-        int prev_pipe_read = -1;
-
-        for (int i = 0; i < num_cmds; i++) {
-            char *args[MAX_ARGS];
-            parse_input(commands[i], args);
-            if (args[0] == NULL) continue;
-
-            // Handle Built-ins
-            if (num_cmds == 1 && handle_builtin(args)) {
-                continue;
-            }
-
-            if (i < num_cmds - 1) pipe(pipefd);
-
-            pid_t pid = fork();
-            if (pid == 0) {
-                if (prev_pipe_read != -1) {
-                    dup2(prev_pipe_read, STDIN_FILENO);
-                    close(prev_pipe_read);
-                }
-                if (i < num_cmds - 1) {
-                    dup2(pipefd[1], STDOUT_FILENO);
-                    close(pipefd[1]);
-                    close(pipefd[0]);
-                }
-                execute_command(args);
-                exit(0);
-            } else {
-                set_foreground_pid(pid);
-                if (prev_pipe_read != -1) close(prev_pipe_read);
-                if (i < num_cmds - 1) {
-                    prev_pipe_read = pipefd[0];
-                    close(pipefd[1]);
-                }
-            }
-        }
-        for (int i = 0; i < num_cmds; i++) wait(NULL);
-        
         free(input);
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -48,6 +48,9 @@ void add_to_history(const char *command) {
     }
     history_tail = new_node;
     history_count++;
+
+    // The predictor learns command sequences from the same history
+    predict_learn(command);
     
     // Limit history size to prevent unbounded memory growth
     if (history_count > MAX_HISTORY) {
@@ -208,5 +211,6 @@ void print_memory_stats(void) {
     }
     
     printf("Approximate history memory: %zu bytes\n", history_mem);
+    print_predictor_stats();
     printf("=========================\n\n");
 }
@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <time.h>
+#include <signal.h>
+#include <dirent.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <readline/readline.h>
+#include "visionos.h"
+
+// Predictive prewarming. Every history line teaches an n-gram model which
+// command usually follows the last one or two. While the prompt waits, the
+// shell warms the interpreter the predicted command needs (a low-priority
+// python3 that only imports its modules) and reads ahead the images named
+// on the last line and on the line being typed.
+
+#define PREDICT_NAMES 64
+#define PREDICT_NAME_LEN 32
+#define PREDICT_TRANSITIONS 512
+#define PREDICT_MIN_COUNT 2       // times a transition was seen before we act on it
+#define PREDICT_MIN_SHARE 0.4     // of all transitions from the same context
+#define PREWARM_INTERVAL 120      // seconds between prewarms of the same interpreter
+#define PREFETCH_MAX_FILES 32     // per prompt
+#define PREFETCH_MAX_BYTES (256L * 1024 * 1024)
+
+extern char **environ;
+
+typedef struct {
+    short prev2;   // -1 for order-1 (bigram) entries
+    short prev1;
+    short next;
+    int count;
+} Transition;
+
+typedef struct {
+    double total;
+    int runs;
+} Timing;
+
+static char names[PREDICT_NAMES][PREDICT_NAME_LEN];
+static int num_names = 0;
+static Transition transitions[PREDICT_TRANSITIONS];
+static int num_transitions = 0;
+static int context[2] = {-1, -1};   // last command, the one before
+
+static int predicted = -1;
+static int warmed = -1;             // command the last prewarm was for
+static pid_t prewarm_pid = -1;
+static time_t last_prewarm[2] = {0, 0};
+
+static char prefetched[PREFETCH_MAX_FILES][SHELL_MAX_INPUT];
+static int num_prefetched = 0;
+static long prefetched_bytes = 0;
+static char last_line[SHELL_MAX_INPUT];
+static char last_scanned[SHELL_MAX_INPUT];
+
+static int stat_predictions = 0, stat_hits = 0, stat_prewarms = 0;
+static long stat_files = 0, stat_bytes = 0;
+static Timing warm_time[PREDICT_NAMES], cold_time[PREDICT_NAMES];
+static int running_cmd = -1, running_warm = 0;
+static struct timespec run_start;
+
+/**
+ * Index of the first command of a line, adding it to the name table
+ */
+static int command_id(const char *line, int add) {
+    char name[PREDICT_NAME_LEN];
+    size_t skip = strspn(line, " \t");
+    size_t len = strcspn(line + skip, " \t|;&{}");
+    if (len == 0 || len >= PREDICT_NAME_LEN) return -1;
+    memcpy(name, line + skip, len);
+    name[len] = '\0';
+
+    for (int i = 0; i < num_names; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    if (!add || num_names == PREDICT_NAMES) return -1;
+    strcpy(names[num_names], name);
+    return num_names++;
+}
+
+/**
+ * Halve every count and drop the ones that reach zero, so the table
+ * stays bounded and old habits fade
+ */
+static void age_transitions(void) {
+    int kept = 0;
+    for (int i = 0; i < num_transitions; i++) {
+        transitions[i].count /= 2;
+        if (transitions[i].count > 0) transitions[kept++] = transitions[i];
+    }
+    num_transitions = kept;
+}
+
+static void count_transition(int prev2, int prev1, int next) {
+    for (int i = 0; i < num_transitions; i++) {
+        Transition *t = &transitions[i];
+        if (t->prev2 == prev2 && t->prev1 == prev1 && t->next == next) {
+            t->count++;
+            return;
+        }
+    }
+    if (num_transitions == PREDICT_TRANSITIONS) age_transitions();
+    if (num_transitions == PREDICT_TRANSITIONS) return;
+    transitions[num_transitions++] = (Transition){prev2, prev1, next, 1};
+}
+
+/**
+ * Most likely next command for a context, or -1 if no choice is clear
+ */
+static int best_next(int prev2, int prev1) {
+    int counts[PREDICT_NAMES] = {0};
+    int total = 0, best = -1;
+    for (int i = 0; i < num_transitions; i++) {
+        Transition *t = &transitions[i];
+        if (t->prev2 != prev2 || t->prev1 != prev1) continue;
+        counts[t->next] += t->count;
+        total += t->count;
+        if (best < 0 || counts[t->next] > counts[best]) best = t->next;
+    }
+    if (best < 0 || counts[best] < PREDICT_MIN_COUNT || counts[best] < PREDICT_MIN_SHARE * total) return -1;
+    return best;
+}
+
+static int predict_next(void) {
+    if (context[0] < 0) return -1;
+    // Order 2 first, then back off to order 1
+    int next = context[1] >= 0 ? best_next(context[1], context[0]) : -1;
+    return next >= 0 ? next : best_next(-1, context[0]);
+}
+
+/**
+ * Learn from a line entered at the prompt (called from add_to_history)
+ */
+void predict_learn(const char *line) {
+    int id = command_id(line, 1);
+    if (predicted >= 0) {
+        stat_predictions++;
+        if (id == predicted) stat_hits++;
+    }
+    running_cmd = id;
+    running_warm = id >= 0 && id == warmed;
+    predicted = -1;
+    warmed = -1;
+
+    strncpy(last_line, line, sizeof(last_line) - 1);
+    if (id < 0) return;
+    if (context[0] >= 0) {
+        count_transition(-1, context[0], id);
+        if (context[1] >= 0) count_transition(context[1], context[0], id);
+    }
+    context[1] = context[0];
+    context[0] = id;
+}
+
+/**
+ * Python modules the predicted command will import, or NULL
+ */
+static const char *warm_imports(const char *cmd, int *slot) {
+    if (strncmp(cmd, CV_PREFIX, strlen(CV_PREFIX)) == 0 ||
+        strncmp(cmd, SH_PREFIX, strlen(SH_PREFIX)) == 0) {
+        *slot = 0;
+        return "import cv2, numpy";
+    }
+    if (strcmp(cmd, "vls") == 0) {
+        *slot = 1;
+        return "import cv2, numpy, torch, ultralytics";
+    }
+    return NULL;
+}
+
+/**
+ * Start a python3 that just imports the modules, which pulls the
+ * interpreter and the shared libraries into the page cache. One at a time.
+ * It is spawned through nice(1), so it never runs at normal priority.
+ */
+static void prewarm_interpreter(int cmd) {
+    int slot;
+    const char *imports = warm_imports(names[cmd], &slot);
+    if (!imports) return;
+    if (prewarm_pid > 0 && kill(prewarm_pid, 0) == 0) {
+        warmed = cmd;   // one is already running
+        return;
+    }
+    time_t now = time(NULL);
+    if (now - last_prewarm[slot] < PREWARM_INTERVAL) {
+        warmed = cmd;   // still warm from the last one
+        return;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char code[128];
+    snprintf(code, sizeof(code), "%s", imports);
+    char *argv[] = {"nice", "-n", "19", "python3", "-c", code, NULL};
+    pid_t pid;
+    if (posix_spawnp(&pid, "nice", &actions, NULL, argv, environ) == 0) {
+        prewarm_pid = pid;
+        last_prewarm[slot] = now;
+        warmed = cmd;
+        stat_prewarms++;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+}
+
+static int already_prefetched(const char *path) {
+    for (int i = 0; i < num_prefetched; i++) {
+        if (strcmp(prefetched[i], path) == 0) return 1;
+    }
+    return 0;
+}
+
+static void readahead_file(const char *path, off_t size) {
+    if (num_prefetched == PREFETCH_MAX_FILES || prefetched_bytes + size > PREFETCH_MAX_BYTES) return;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+    strncpy(prefetched[num_prefetched++], path, SHELL_MAX_INPUT - 1);
+    prefetched_bytes += size;
+    stat_files++;
+    stat_bytes += size;
+}
+
+/**
+ * Images and the raw .npy intermediates, the inputs the cv apps read
+ * (IMAGE_EXTENSIONS in apps/cv_utils.py)
+ */
+static int is_image_path(const char *path) {
+    static const char *exts[] = {".jpg", ".jpeg", ".png", ".bmp", ".webp", ".tif", ".tiff", ".npy", NULL};
+    const char *dot = strrchr(path, '.');
+    if (!dot || strchr(dot, '/')) return 0;
+    for (int i = 0; exts[i]; i++) {
+        if (strcasecmp(dot, exts[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Read ahead the images named on a line, and the images in directories
+ * given to cv-* commands. Other words (a bare "/" or "~", a vls tree)
+ * could name far more than the command will read.
+ */
+static void prefetch_line(const char *line) {
+    char copy[SHELL_MAX_INPUT];
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char *rest = copy, *stage;
+    while ((stage = strsep(&rest, "|;&{}")) != NULL) {
+        char *save, *token = strtok_r(stage, " \t<>", &save);
+        int cv_stage = token && strncmp(token, CV_PREFIX, strlen(CV_PREFIX)) == 0;
+        if (token) token = strtok_r(NULL, " \t<>", &save);
+
+        for (; token; token = strtok_r(NULL, " \t<>", &save)) {
+            struct stat st;
+            if (token[0] == '-' || already_prefetched(token) || stat(token, &st) != 0) continue;
+            if (S_ISREG(st.st_mode) && is_image_path(token)) {
+                readahead_file(token, st.st_size);
+            } else if (S_ISDIR(st.st_mode) && cv_stage) {
+                DIR *dir = opendir(token);
+                struct dirent *entry;
+                while (dir && (entry = readdir(dir)) && num_prefetched < PREFETCH_MAX_FILES) {
+                    char path[SHELL_MAX_INPUT];
+                    snprintf(path, sizeof(path), "%s/%s", token, entry->d_name);
+                    if (entry->d_name[0] != '.' && is_image_path(entry->d_name) &&
+                        stat(path, &st) == 0 && S_ISREG(st.st_mode) && !already_prefetched(path)) {
+                        readahead_file(path, st.st_size);
+                    }
+                }
+                if (dir) closedir(dir);
+            }
+        }
+    }
+}
+
+/**
+ * Called before each prompt: predict the next command and warm up for it.
+ * The last line's files are likely inputs of the next one.
+ */
+void prewarm_predicted(void) {
+    num_prefetched = 0;
+    prefetched_bytes = 0;
+    last_scanned[0] = '\0';
+
+    predicted = predict_next();
+    if (predicted >= 0) prewarm_interpreter(predicted);
+    if (last_line[0]) prefetch_line(last_line);
+}
+
+/**
+ * readline idle hook: read ahead the files on the line being typed
+ */
+static int prefetch_typed(void) {
+    if (rl_line_buffer && strcmp(rl_line_buffer, last_scanned) != 0) {
+        strncpy(last_scanned, rl_line_buffer, sizeof(last_scanned) - 1);
+        prefetch_line(last_scanned);
+    }
+    return 0;
+}
+
+void setup_predictor(void) {
+    rl_event_hook = prefetch_typed;
+}
+
+static double elapsed_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void predict_command_started(void) {
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+}
+
+/**
+ * Record how long the command took, split by whether it was prewarmed
+ */
+void predict_command_finished(void) {
+    if (running_cmd < 0) return;
+    Timing *t = running_warm ? &warm_time[running_cmd] : &cold_time[running_cmd];
+    t->total += elapsed_since(&run_start);
+    t->runs++;
+    running_cmd = -1;
+}
+
+void print_predictor_stats(void) {
+    printf("Predictor: %d predictions, %d hits", stat_predictions, stat_hits);
+    if (stat_predictions > 0) printf(" (%.1f%%)", 100.0 * stat_hits / stat_predictions);
+    printf("\n");
+    printf("Interpreter prewarms: %d, files read ahead: %ld (%.1f MB)\n",
+           stat_prewarms, stat_files, stat_bytes / (1024.0 * 1024.0));
+
+    // Saving per command = cold average - warm average, over its warm runs
+    double saved = 0.0;
+    int measured = 0;
+    for (int i = 0; i < num_names; i++) {
+        if (warm_time[i].runs == 0 || cold_time[i].runs == 0) continue;
+        double gain = cold_time[i].total / cold_time[i].runs - warm_time[i].total / warm_time[i].runs;
+        if (gain > 0) saved += gain * warm_time[i].runs;
+        measured = 1;
+    }
+    if (measured) printf("Estimated latency saved: %.2f s\n", saved);
+    else printf("Estimated latency saved: n/a (needs warm and cold runs of a command)\n");
+}
@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "visionos.h"
+
+// Batch execution of a file of command lines (visionos -f script.vos -j N).
+// File dependencies between lines are inferred from redirections, output
+// options and path-like arguments; independent lines run concurrently and
+// their output is replayed in script order. A failed line only skips the
+// lines that conflict with it on a file; builtins that change shell state
+// order the lines around them without passing failures on.
+
+#define MAX_SCRIPT_PATHS 32
+#define MAX_UNREPLAYED 64     // lines holding captured output (2 fds each)
+
+#define DEP_ORDER 1           // after a barrier: ordering only
+#define DEP_FILE 2            // conflict on a file: a failure skips the line
+
+typedef enum {
+    LINE_PENDING = 0,
+    LINE_RUNNING,
+    LINE_DONE,
+    LINE_SKIPPED
+} LineState;
+
+typedef struct {
+    char *text;
+    int lineno;
+    char *reads[MAX_SCRIPT_PATHS];
+    char *writes[MAX_SCRIPT_PATHS];
+    int num_reads, num_writes;
+    int barrier;        // builtins (cd, ...) run in the shell and order everything
+    int *deps;
+    unsigned char *dep_kinds;
+    int num_deps;
+    LineState state;
+    int status;
+    pid_t pid;
+    FILE *out, *err;
+} ScriptLine;
+
+static int is_output_option(const char *arg) {
+    return strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0 ||
+           strcmp(arg, "--out_dir") == 0;
+}
+
+/**
+ * Builtins that change the shell's state. Read-only ones (history,
+ * mem-stats, cache-stats, sysmon, vhash) run in a worker like any command.
+ */
+static int is_stateful_builtin(const char *cmd) {
+    const char *names[] = {"cd", "exit", "clear-history", "cache-clear", NULL};
+    for (int i = 0; names[i]; i++) {
+        if (strcmp(cmd, names[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static void add_path(char **list, int *count, const char *path) {
+    if (*count >= MAX_SCRIPT_PATHS) return;
+    if (strncmp(path, "./", 2) == 0) path += 2;
+    list[(*count)++] = safe_strdup(path);
+}
+
+/**
+ * Collect the files a line reads and writes. Every non-option argument is
+ * treated as a possible input, which errs on the side of ordering lines.
+ */
+static void scan_line_paths(ScriptLine *line) {
+    char *copy = safe_strdup(line->text);
+    char *args[MAX_ARGS];
+    char *cmd_ptr = copy, *stage;
+    int first_stage = 1;
+
+    // Stages of pipelines and of "|& { a ; b }" fan-out branches
+    while ((stage = strsep(&cmd_ptr, "|;{}&")) != NULL) {
+        int argc = parse_input(stage, args);
+        if (argc == 0) continue;
+        if (first_stage && is_stateful_builtin(args[0])) line->barrier = 1;
+        first_stage = 0;
+        // A barrier is ordered against every line anyway; its arguments
+        // (the directory of a cd) must not turn that order into a file conflict
+        if (line->barrier) continue;
+
+        for (int i = 1; i < argc; i++) {
+            if ((strcmp(args[i], ">") == 0 || strcmp(args[i], ">>") == 0 ||
+                 is_output_option(args[i])) && i + 1 < argc) {
+                add_path(line->writes, &line->num_writes, args[++i]);
+            } else if (strcmp(args[i], "<") == 0 && i + 1 < argc) {
+                add_path(line->reads, &line->num_reads, args[++i]);
+            } else if (args[i][0] != '-') {
+                add_path(line->reads, &line->num_reads, args[i]);
+            }
+        }
+    }
+    free(copy);
+}
+
+/**
+ * Same path, or one is a directory containing the other
+ */
+static int paths_overlap(const char *a, const char *b) {
+    size_t la = strlen(a), lb = strlen(b);
+    if (la == lb) return strcmp(a, b) == 0;
+    if (la < lb) return strncmp(a, b, la) == 0 && (b[la] == '/' || a[la - 1] == '/');
+    return strncmp(a, b, lb) == 0 && (a[lb] == '/' || b[lb - 1] == '/');
+}
+
+static int any_overlap(char *const *x, int nx, char *const *y, int ny) {
+    for (int i = 0; i < nx; i++)
+        for (int j = 0; j < ny; j++)
+            if (paths_overlap(x[i], y[j])) return 1;
+    return 0;
+}
+
+/**
+ * How line b (later) depends on line a: DEP_FILE if they conflict on a
+ * file (read-after-write, write-after-write or write-after-read),
+ * DEP_ORDER if either is a barrier, otherwise 0
+ */
+static int depends_on(const ScriptLine *b, const ScriptLine *a) {
+    if (any_overlap(a->writes, a->num_writes, b->reads, b->num_reads) ||
+        any_overlap(a->writes, a->num_writes, b->writes, b->num_writes) ||
+        any_overlap(a->reads, a->num_reads, b->writes, b->num_writes)) return DEP_FILE;
+    return (a->barrier || b->barrier) ? DEP_ORDER : 0;
+}
+
+static int load_script(const char *path, ScriptLine **out) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror("Cannot open script");
+        return -1;
+    }
+
+    ScriptLine *lines = NULL;
+    int count = 0, capacity = 0, lineno = 0;
+    char *buf = NULL;
+    size_t buf_size = 0;
+    ssize_t len;
+
+    while ((len = getline(&buf, &buf_size, f)) != -1) {
+        lineno++;
+        while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) buf[--len] = '\0';
+        char *text = buf;
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '\0' || *text == '#') continue;
+        if (strlen(text) >= SHELL_MAX_INPUT) {
+            fprintf(stderr, "%s:%d: line too long, ignored\n", path, lineno);
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            ScriptLine *grown = realloc(lines, capacity * sizeof(ScriptLine));
+            if (!grown) {
+                fprintf(stderr, "Memory allocation failed for script lines\n");
+                break;
+            }
+            lines = grown;
+        }
+        ScriptLine *line = &lines[count++];
+        memset(line, 0, sizeof(*line));
+        line->text = safe_strdup(text);
+        line->lineno = lineno;
+        scan_line_paths(line);
+    }
+    free(buf);
+    fclose(f);
+
+    // Direct dependencies on earlier lines
+    for (int i = 0; i < count; i++) {
+        lines[i].deps = malloc((i + 1) * sizeof(int));
+        lines[i].dep_kinds = malloc(i + 1);
+        for (int j = 0; j < i; j++) {
+            int kind = depends_on(&lines[i], &lines[j]);
+            if (!kind) continue;
+            lines[i].dep_kinds[lines[i].num_deps] = (unsigned char)kind;
+            lines[i].deps[lines[i].num_deps++] = j;
+        }
+    }
+
+    *out = lines;
+    return count;
+}
+
+static void free_script(ScriptLine *lines, int count) {
+    for (int i = 0; i < count; i++) {
+        free(lines[i].text);
+        for (int j = 0; j < lines[i].num_reads; j++) free(lines[i].reads[j]);
+        for (int j = 0; j < lines[i].num_writes; j++) free(lines[i].writes[j]);
+        free(lines[i].deps);
+        free(lines[i].dep_kinds);
+        if (lines[i].out) fclose(lines[i].out);
+        if (lines[i].err) fclose(lines[i].err);
+    }
+    free(lines);
+}
+
+static void replay(FILE *from, FILE *to) {
+    char chunk[4096];
+    size_t n;
+    fflush(from);
+    rewind(from);
+    while ((n = fread(chunk, 1, sizeof(chunk), from)) > 0) fwrite(chunk, 1, n, to);
+    fflush(to);
+}
+
+/**
+ * Print the captured output of finished lines, in script order, up to the
+ * first line that is still pending or running
+ */
+static void flush_finished(const char *path, ScriptLine *lines, int count,
+                           int *next_output, int *exit_status) {
+    while (*next_output < count &&
+           (lines[*next_output].state == LINE_DONE || lines[*next_output].state == LINE_SKIPPED)) {
+        ScriptLine *line = &lines[(*next_output)++];
+        if (line->out) {
+            replay(line->out, stdout);
+            fclose(line->out);
+            line->out = NULL;
+        }
+        if (line->err) {
+            replay(line->err, stderr);
+            fclose(line->err);
+            line->err = NULL;
+        }
+        if (line->state == LINE_SKIPPED) {
+            fprintf(stderr, "%s:%d: skipped (dependency failed): %s\n", path, line->lineno, line->text);
+        } else if (line->status != 0) {
+            fprintf(stderr, "%s:%d: exit status %d: %s\n", path, line->lineno, line->status, line->text);
+        }
+        if (line->status != 0 && *exit_status == 0) *exit_status = line->status;
+    }
+}
+
+/**
+ * Fork a worker for one line with its stdout/stderr captured to temp files
+ */
+static int launch_line(ScriptLine *line, int slot, int jobs) {
+    line->out = tmpfile();
+    line->err = tmpfile();
+    if (!line->out || !line->err) {
+        perror("tmpfile failed");
+        return 0;
+    }
+    // Keep other lines' capture files out of this line's commands
+    fcntl(fileno(line->out), F_SETFD, FD_CLOEXEC);
+    fcntl(fileno(line->err), F_SETFD, FD_CLOEXEC);
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        return 0;
+    }
+    if (pid == 0) {
+        // A command missing its input would otherwise wait on our stdin;
+        // a "<" on the line still replaces this
+        int null_fd = open("/dev/null", O_RDONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+            close(null_fd);
+        }
+        dup2(fileno(line->out), STDOUT_FILENO);
+        dup2(fileno(line->err), STDERR_FILENO);
+        // Concurrent lines split the CPUs; stages then split their slice
+        restrict_to_cpu_slice(slot, jobs);
+        int status = run_command_line(line->text);
+        fflush(stdout);
+        _exit(status);
+    }
+    line->pid = pid;
+    line->state = LINE_RUNNING;
+    return 1;
+}
+
+static int is_exit_line(const char *text) {
+    size_t skip = strspn(text, " \t");
+    return strncmp(text + skip, "exit", 4) == 0 && strchr(" \t", text[skip + 4]) != NULL;
+}
+
+/**
+ * Run a script file. Returns 0 if every line succeeded, otherwise the
+ * exit status of the first failing line (130 if interrupted). An "exit"
+ * line ends the script with the status so far.
+ */
+int run_script(const char *path, int jobs) {
+    ScriptLine *lines;
+    int count = load_script(path, &lines);
+    if (count < 0) return 1;
+
+    // We collect children ourselves; don't let the interactive reaper race us
+    signal(SIGCHLD, SIG_DFL);
+    setup_batch_signals();
+
+    int *slots = calloc(jobs, sizeof(int));   // slot -> running line + 1
+    int finished = 0, running = 0, next_output = 0, exit_status = 0, stop = 0;
+
+    while (finished < count && !(stop && running == 0)) {
+        if (batch_interrupted()) stop = 1;
+
+        // Launch every ready line while there are free slots. Lines far
+        // ahead of a slow one wait, so captured output stays bounded.
+        for (int i = 0; i < count && running < jobs && !stop && i < next_output + MAX_UNREPLAYED; i++) {
+            ScriptLine *line = &lines[i];
+            if (line->state != LINE_PENDING) continue;
+
+            int ready = 1, failed_dep = 0;
+            for (int d = 0; d < line->num_deps; d++) {
+                const ScriptLine *dep = &lines[line->deps[d]];
+                if (dep->state != LINE_DONE && dep->state != LINE_SKIPPED) ready = 0;
+                else if (dep->status != 0 && line->dep_kinds[d] == DEP_FILE) failed_dep = 1;
+            }
+            if (failed_dep) {
+                line->state = LINE_SKIPPED;
+                line->status = 1;
+                finished++;
+                continue;
+            }
+            if (!ready) continue;
+
+            // Builtins change shell state, so they run here, alone
+            if (line->barrier) {
+                if (running > 0) break;
+                flush_finished(path, lines, count, &next_output, &exit_status);
+                if (is_exit_line(line->text)) {
+                    // The builtin would exit(0) and lose earlier failures
+                    stop = 1;
+                    break;
+                }
+                char *copy = safe_strdup(line->text);
+                line->status = run_command_line(copy);
+                free(copy);
+                line->state = LINE_DONE;
+                finished++;
+                continue;
+            }
+
+            int slot = 0;
+            while (slots[slot]) slot++;
+            if (!launch_line(line, slot, jobs)) {
+                line->state = LINE_DONE;
+                line->status = 1;
+                finished++;
+                continue;
+            }
+            slots[slot] = i + 1;
+            running++;
+        }
+
+        // Replay finished lines in script order
+        flush_finished(path, lines, count, &next_output, &exit_status);
+
+        if (running == 0) continue;
+
+        int wstatus;
+        pid_t pid = waitpid(-1, &wstatus, 0);
+        if (pid < 0) break;
+        for (int s = 0; s < jobs; s++) {
+            if (!slots[s] || lines[slots[s] - 1].pid != pid) continue;
+            ScriptLine *line = &lines[slots[s] - 1];
+            line->status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+            line->state = LINE_DONE;
+            slots[s] = 0;
+            running--;
+            finished++;
+            break;
+        }
+    }
+
+    flush_finished(path, lines, count, &next_output, &exit_status);
+    if (batch_interrupted()) {
+        fprintf(stderr, "%s: interrupted\n", path);
+        if (exit_status == 0) exit_status = 130;
+    }
+
+    free(slots);
+    free_script(lines, count);
+    return exit_status;
+}
@@ -14,7 +14,7 @@ char *command_generator(const char *text, int state) {
     static DIR *dir_scripts = NULL;
     struct dirent *entry;
 
-    char *builtins[] = {"history", "clear-history", "mem-stats", "exit", "vls", "cd", NULL};
+    char *builtins[] = {"history", "clear-history", "mem-stats", "cache-stats", "cache-clear", "sysmon", "vhash", "exit", "vls", "cd", NULL};
 
     if (state == 0) {
         list_index = 0;
@@ -9,14 +9,32 @@
 #include <string.h>
 
 static volatile pid_t foreground_pid = -1;
+static volatile sig_atomic_t builtin_loop_active = 0;
+static volatile sig_atomic_t interrupted = 0;
 
 void set_foreground_pid(pid_t pid) {
     foreground_pid = pid;
 }
 
+/**
+ * Long-running builtins (e.g. sysmon) poll this to stop on Ctrl+C
+ */
+void set_builtin_loop(int active) {
+    builtin_loop_active = active;
+    interrupted = 0;
+}
+
+int builtin_interrupted(void) {
+    return interrupted;
+}
+
 void handle_sigint(int sig) {
     (void)sig;
-    if (foreground_pid > 0) {
+    if (builtin_loop_active) {
+        interrupted = 1;
+        const char *msg = "\n";
+        write(STDOUT_FILENO, msg, strlen(msg));
+    } else if (foreground_pid > 0) {
         // Child handles it, we just print newline if needed
         const char *msg = "\n";
         write(STDOUT_FILENO, msg, strlen(msg));
@@ -26,6 +44,28 @@ void handle_sigint(int sig) {
     }
 }
 
+/**
+ * Batch mode (-f): Ctrl+C reaches the running commands directly; the
+ * script only stops launching lines
+ */
+static void handle_sigint_batch(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+int batch_interrupted(void) {
+    return interrupted;
+}
+
+void setup_batch_signals(void) {
+    struct sigaction sa;
+    sa.sa_handler = handle_sigint_batch;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGTSTP, SIG_DFL);
+}
+
 void handle_sigtstp(int sig) {
     (void)sig;
     if (foreground_pid > 0) {
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include "visionos.h"
+
+#define SYSMON_TOP_ROWS 20
+#define SYSMON_COMM_LEN 32
+
+// One sample of a process, parsed from /proc/<pid>/stat
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    char comm[SYSMON_COMM_LEN];
+    unsigned long long ticks;   // utime + stime
+    long rss_pages;
+    double cpu_percent;         // over the last interval
+} ProcSample;
+
+// Two generations of samples, swapped each refresh. Buffers only grow,
+// so a steady-state refresh performs no allocation.
+static ProcSample *samples_cur = NULL;
+static ProcSample *samples_prev = NULL;
+static int cur_count = 0, prev_count = 0;
+static int capacity = 0;
+static char read_buf[4096];
+
+static int compare_pid(const void *a, const void *b) {
+    pid_t pa = ((const ProcSample *)a)->pid;
+    pid_t pb = ((const ProcSample *)b)->pid;
+    return (pa > pb) - (pa < pb);
+}
+
+static int compare_cpu_desc(const void *a, const void *b) {
+    const ProcSample *const *pa = a;
+    const ProcSample *const *pb = b;
+    if ((*pa)->cpu_percent != (*pb)->cpu_percent)
+        return (*pa)->cpu_percent < (*pb)->cpu_percent ? 1 : -1;
+    return ((*pb)->rss_pages > (*pa)->rss_pages) - ((*pb)->rss_pages < (*pa)->rss_pages);
+}
+
+/**
+ * Read a small /proc file into the shared buffer with a single read()
+ */
+static ssize_t read_proc_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, read_buf, sizeof(read_buf) - 1);
+    close(fd);
+    if (n < 0) return -1;
+    read_buf[n] = '\0';
+    return n;
+}
+
+/**
+ * Parse /proc/<pid>/stat. comm may contain spaces and parentheses,
+ * so fields are located from the last ')'.
+ */
+static int parse_stat(pid_t pid, ProcSample *out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    if (read_proc_file(path) <= 0) return 0;
+
+    char *open_paren = strchr(read_buf, '(');
+    char *close_paren = strrchr(read_buf, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return 0;
+
+    size_t len = (size_t)(close_paren - open_paren - 1);
+    if (len >= SYSMON_COMM_LEN) len = SYSMON_COMM_LEN - 1;
+    memcpy(out->comm, open_paren + 1, len);
+    out->comm[len] = '\0';
+
+    // Fields after comm start at field 3 (state)
+    char *p = close_paren + 2;
+    unsigned long long utime = 0, stime = 0;
+    int field = 3;
+    while (*p && field <= 24) {
+        char *end;
+        if (field == 4) out->ppid = (pid_t)strtol(p, &end, 10);
+        else if (field == 14) utime = strtoull(p, &end, 10);
+        else if (field == 15) stime = strtoull(p, &end, 10);
+        else if (field == 24) out->rss_pages = strtol(p, &end, 10);
+        p = strchr(p, ' ');
+        if (!p) break;
+        p++;
+        field++;
+    }
+
+    out->pid = pid;
+    out->ticks = utime + stime;
+    out->cpu_percent = 0.0;
+    return 1;
+}
+
+/**
+ * Collect one sample of every process into samples_cur, sorted by pid
+ */
+static void collect_samples(void) {
+    DIR *proc = opendir("/proc");
+    struct dirent *entry;
+    cur_count = 0;
+    if (!proc) return;
+
+    while ((entry = readdir(proc))) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        if (cur_count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 512;
+            ProcSample *a = realloc(samples_cur, new_capacity * sizeof(ProcSample));
+            if (!a) break;
+            samples_cur = a;
+            ProcSample *b = realloc(samples_prev, new_capacity * sizeof(ProcSample));
+            if (!b) break;
+            samples_prev = b;
+            capacity = new_capacity;
+        }
+        if (parse_stat((pid_t)atoi(entry->d_name), &samples_cur[cur_count])) {
+            cur_count++;
+        }
+    }
+    closedir(proc);
+    qsort(samples_cur, cur_count, sizeof(ProcSample), compare_pid);
+}
+
+static ProcSample *find_sample(ProcSample *set, int count, pid_t pid) {
+    ProcSample key;
+    key.pid = pid;
+    return bsearch(&key, set, count, sizeof(ProcSample), compare_pid);
+}
+
+/**
+ * True if pid is this shell or one of its descendants: cv workers, vls,
+ * stitch jobs, ... Other sessions, even of the same user, are not shown.
+ */
+static int in_shell_tree(pid_t pid, pid_t shell_pid) {
+    for (int depth = 0; depth < 64 && pid > 1; depth++) {
+        if (pid == shell_pid) return 1;
+        ProcSample *s = find_sample(samples_cur, cur_count, pid);
+        if (!s) return 0;
+        pid = s->ppid;
+    }
+    return 0;
+}
+
+static int read_cpu_totals(unsigned long long *total, unsigned long long *idle) {
+    if (read_proc_file("/proc/stat") <= 0) return 0;
+    unsigned long long v[8] = {0};
+    if (sscanf(read_buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+               &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 4) return 0;
+    *idle = v[3] + v[4];
+    *total = 0;
+    for (int i = 0; i < 8; i++) *total += v[i];
+    return 1;
+}
+
+static long read_mem_total_kb(void) {
+    long kb = 0;
+    if (read_proc_file("/proc/meminfo") > 0) {
+        sscanf(read_buf, "MemTotal: %ld kB", &kb);
+    }
+    return kb;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sysmon_usage(void) {
+    printf("Usage: sysmon [-i seconds] [-n count] [-t]\n");
+    printf("  -i seconds  Refresh interval (default: 1)\n");
+    printf("  -n count    Stop after count refreshes (default: until Ctrl+C)\n");
+    printf("  -t          Only show this shell and its child processes\n");
+}
+
+/**
+ * Native replacement for sh-cpu_use: per-interval CPU% and RSS from /proc.
+ * Returns the builtin's exit status: 1 on a usage error, otherwise 0.
+ */
+int run_sysmon(char **args) {
+    double interval = 1.0;
+    int iterations = 0;
+    int tree_only = 0;
+
+    for (int i = 1; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-i") == 0 && args[i + 1]) {
+            interval = atof(args[++i]);
+        } else if (strcmp(args[i], "-n") == 0 && args[i + 1]) {
+            iterations = atoi(args[++i]);
+        } else if (strcmp(args[i], "-t") == 0 || strcmp(args[i], "--tree") == 0) {
+            tree_only = 1;
+        } else {
+            sysmon_usage();
+            return 1;
+        }
+    }
+    if (interval < 0.1) interval = 0.1;
+
+    long clk_tck = sysconf(_SC_CLK_TCK);
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    long mem_total_kb = read_mem_total_kb();
+    pid_t shell_pid = getpid();
+    ProcSample **rows = NULL;
+    int rows_capacity = 0;
+
+    unsigned long long prev_total = 0, prev_idle = 0, total = 0, idle = 0;
+    read_cpu_totals(&prev_total, &prev_idle);
+    collect_samples();
+    double prev_time = now_seconds();
+
+    set_builtin_loop(1);
+    for (int refresh = 0; iterations == 0 || refresh < iterations; refresh++) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)interval;
+        ts.tv_nsec = (long)((interval - (double)ts.tv_sec) * 1e9);
+        nanosleep(&ts, NULL);
+        if (builtin_interrupted()) break;
+
+        // Previous generation becomes the baseline for this interval
+        ProcSample *swap = samples_prev;
+        samples_prev = samples_cur;
+        samples_cur = swap;
+        prev_count = cur_count;
+
+        collect_samples();
+        read_cpu_totals(&total, &idle);
+        double now = now_seconds();
+        double elapsed_ticks = (now - prev_time) * clk_tck;
+        prev_time = now;
+
+        if (rows_capacity < cur_count) {
+            ProcSample **r = realloc(rows, cur_count * sizeof(ProcSample *));
+            if (!r) break;
+            rows = r;
+            rows_capacity = cur_count;
+        }
+
+        int nrows = 0;
+        double self_cpu = 0.0;
+        for (int i = 0; i < cur_count; i++) {
+            ProcSample *s = &samples_cur[i];
+            ProcSample *old = find_sample(samples_prev, prev_count, s->pid);
+            unsigned long long base = (old && old->ticks <= s->ticks) ? old->ticks : s->ticks;
+            s->cpu_percent = elapsed_ticks > 0 ? 100.0 * (s->ticks - base) / elapsed_ticks : 0.0;
+            if (s->pid == shell_pid) self_cpu = s->cpu_percent;
+            if (tree_only && !in_shell_tree(s->pid, shell_pid)) continue;
+            rows[nrows++] = s;
+        }
+        qsort(rows, nrows, sizeof(ProcSample *), compare_cpu_desc);
+
+        unsigned long long total_diff = total - prev_total;
+        unsigned long long idle_diff = idle - prev_idle;
+        double cpu_usage = total_diff ? 100.0 * (total_diff - idle_diff) / total_diff : 0.0;
+        prev_total = total;
+        prev_idle = idle;
+
+        time_t wall = time(NULL);
+        char timestamp[16];
+        strftime(timestamp, sizeof(timestamp), "%H:%M:%S", localtime(&wall));
+
+        // ANSI clear instead of forking clear(1)
+        printf("\033[H\033[2J");
+        printf("===============================================================\n");
+        printf("  VisionOS System Monitor                  %s\n", timestamp);
+        printf("  Total CPU Usage: %.1f%%   sysmon: %.2f%%\n", cpu_usage, self_cpu);
+        printf("  %s (Top %d by CPU)\n", tree_only ? "VisionOS process trees" : "All processes", SYSMON_TOP_ROWS);
+        printf("===============================================================\n");
+        printf("%-8s %-8s %-20s %7s %10s %6s\n", "PID", "PPID", "COMMAND", "CPU%", "RSS(MB)", "MEM%");
+        for (int i = 0; i < nrows && i < SYSMON_TOP_ROWS; i++) {
+            ProcSample *s = rows[i];
+            long rss_kb = s->rss_pages * page_kb;
+            printf("%-8d %-8d %-20.20s %7.1f %10.1f %6.1f\n",
+                   (int)s->pid, (int)s->ppid, s->comm, s->cpu_percent,
+                   rss_kb / 1024.0, mem_total_kb ? 100.0 * rss_kb / mem_total_kb : 0.0);
+        }
+        printf("---------------------------------------------------------------\n");
+        printf("[CTRL+C to Exit] | Refresh: %.1fs\n", interval);
+        fflush(stdout);
+    }
+    set_builtin_loop(0);
+
+    free(rows);
+    return 0;
+}
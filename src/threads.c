@@ -0,0 +1,184 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include "visionos.h"
+
+// Thread-count variables honoured by OpenCV, OpenMP, BLAS and our own apps
+static const char *thread_env_vars[] = {
+    "VISIONOS_THREADS", "OMP_NUM_THREADS", "OPENBLAS_NUM_THREADS",
+    "MKL_NUM_THREADS", "NUMEXPR_NUM_THREADS", NULL
+};
+#define THREAD_ENV_COUNT 5
+
+extern char **environ;
+
+static int is_thread_env_entry(const char *entry) {
+    for (int i = 0; thread_env_vars[i] != NULL; i++) {
+        size_t len = strlen(thread_env_vars[i]);
+        if (strncmp(entry, thread_env_vars[i], len) == 0 && entry[len] == '=') return 1;
+    }
+    return 0;
+}
+
+static int is_heavy_stage(char **args) {
+    if (args[0] == NULL) return 0;
+    return strncmp(args[0], CV_PREFIX, strlen(CV_PREFIX)) == 0 ||
+           strncmp(args[0], SH_PREFIX, strlen(SH_PREFIX)) == 0 ||
+           strcmp(args[0], "vls") == 0;
+}
+
+/**
+ * Strip a leading "VISIONOS_THREADS=N" token and return N (0 if absent)
+ */
+static int take_thread_override(char **args) {
+    const char *prefix = "VISIONOS_THREADS=";
+    if (args[0] == NULL || strncmp(args[0], prefix, strlen(prefix)) != 0) return 0;
+
+    int n = atoi(args[0] + strlen(prefix));
+    int i = 0;
+    while (args[i] != NULL) {
+        args[i] = args[i + 1];
+        i++;
+    }
+    return n > 0 ? n : 0;
+}
+
+/**
+ * List the CPUs this shell may run on
+ */
+static int allowed_cpus(int *cpus, int max) {
+    cpu_set_t set;
+    int count = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus[count++] = cpu;
+        }
+    }
+    if (count == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int cpu = 0; cpu < n && count < max; cpu++) cpus[count++] = cpu;
+    }
+    return count;
+}
+
+/**
+ * Split the shell's CPUs between the CV/vls/sh stages of a pipeline so
+ * that concurrent stages do not each start one thread per core.
+ * Stages prefixed with VISIONOS_THREADS=N take N cores first; the rest
+ * are shared evenly. Plain commands get no budget.
+ */
+void plan_thread_budgets(char **stage_args[], int num_stages, ThreadBudget *budgets) {
+    int heavy = 0, reserved = 0, shared_stages = 0;
+
+    for (int i = 0; i < num_stages; i++) {
+        budgets[i].threads = take_thread_override(stage_args[i]);
+        budgets[i].first_cpu = 0;
+        budgets[i].overridden = budgets[i].threads > 0;
+        if (!budgets[i].overridden && !is_heavy_stage(stage_args[i])) continue;
+        heavy++;
+        if (budgets[i].overridden) reserved += budgets[i].threads;
+        else shared_stages++;
+    }
+    if (heavy == 0) return;
+
+    int cpus[CPU_SETSIZE];
+    int ncpu = allowed_cpus(cpus, CPU_SETSIZE);
+    int remaining = ncpu - reserved;
+    int next_cpu = 0;
+    int shared_index = 0;
+
+    for (int i = 0; i < num_stages; i++) {
+        if (!budgets[i].overridden) {
+            if (!is_heavy_stage(stage_args[i])) continue;
+            // Even split; the first stages absorb the remainder
+            int share = remaining > 0 ? remaining / shared_stages : 0;
+            if (remaining > 0 && shared_index < remaining % shared_stages) share++;
+            budgets[i].threads = share > 0 ? share : 1;
+            shared_index++;
+        }
+        budgets[i].first_cpu = next_cpu % ncpu;
+        next_cpu += budgets[i].threads;
+    }
+}
+
+/**
+ * Environment for a stage with a budget: ours, with the thread-count
+ * variables overridden. Returns NULL when the stage has no budget.
+ * Release with free_budget_env().
+ */
+char **budget_env(const ThreadBudget *budget) {
+    if (budget->threads <= 0) return NULL;
+
+    int count = 0;
+    while (environ[count] != NULL) count++;
+    char **env = malloc((count + THREAD_ENV_COUNT + 1) * sizeof(char *));
+    if (!env) return NULL;
+
+    // Overrides first, so free_budget_env() knows which strings it owns
+    int n = 0;
+    for (int i = 0; thread_env_vars[i] != NULL; i++) {
+        char entry[64];
+        snprintf(entry, sizeof(entry), "%s=%d", thread_env_vars[i], budget->threads);
+        env[n++] = safe_strdup(entry);
+    }
+    for (int i = 0; i < count; i++) {
+        if (!is_thread_env_entry(environ[i])) env[n++] = environ[i];
+    }
+    env[n] = NULL;
+    return env;
+}
+
+void free_budget_env(char **env) {
+    if (!env) return;
+    for (int i = 0; i < THREAD_ENV_COUNT; i++) free(env[i]);
+    free(env);
+}
+
+static cpu_set_t shell_affinity;
+static int affinity_pinned = 0;
+
+/**
+ * Pin the shell to a stage's CPU slice so the child spawned next inherits
+ * it from its first instruction; restore_shell_affinity() undoes this
+ * right after the spawn.
+ */
+void pin_for_stage(const ThreadBudget *budget) {
+    if (budget->threads <= 0) return;
+
+    int cpus[CPU_SETSIZE];
+    int ncpu = allowed_cpus(cpus, CPU_SETSIZE);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < budget->threads && i < ncpu; i++) {
+        CPU_SET(cpus[(budget->first_cpu + i) % ncpu], &set);
+    }
+    if (sched_getaffinity(0, sizeof(shell_affinity), &shell_affinity) != 0) return;
+    affinity_pinned = sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void restore_shell_affinity(void) {
+    if (!affinity_pinned) return;
+    sched_setaffinity(0, sizeof(shell_affinity), &shell_affinity);
+    affinity_pinned = 0;
+}
+
+/**
+ * Confine this process to slot/slots of the allowed CPUs, e.g. one of
+ * several concurrently running script lines
+ */
+void restrict_to_cpu_slice(int slot, int slots) {
+    int cpus[CPU_SETSIZE];
+    int ncpu = allowed_cpus(cpus, CPU_SETSIZE);
+    if (slots <= 1 || ncpu < 2) return;
+
+    int per_slot = ncpu / slots > 0 ? ncpu / slots : 1;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < per_slot; i++) {
+        CPU_SET(cpus[(slot * per_slot + i) % ncpu], &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+}
@@ -2,13 +2,17 @@
 #define VISIONOS_H
 
 #include <sys/types.h>
+#include <signal.h>
+#include <stdint.h>
 
 #define SHELL_MAX_INPUT 1024
 #define MAX_ARGS 64
 #define MAX_HISTORY 100
+#define MAX_FANOUT 8
 #define TIMEOUT_SECONDS 60
 #define CV_PREFIX "cv-"
 #define SH_PREFIX "sh-"
+#define IMG_CACHE_DIR "/dev/shm/visionos-cache"     // + "-<uid>", one per user
 
 // Enums
 typedef enum {
@@ -24,19 +28,44 @@ typedef enum {
     REDIRECT_INPUT      // <
 } RedirectType;
 
+// Per-stage thread budget for pipelines
+typedef struct {
+    int threads;     // 0 = no budget
+    int first_cpu;   // index into the shell's allowed CPUs
+    int overridden;  // set by a VISIONOS_THREADS=N prefix
+} ThreadBudget;
+
 // Utils
 void get_apps_path(char *buffer, size_t size);
 int parse_input(char *input, char **args);
 
+// Kernel
+int run_command_line(char *input);
+
+// Fan-out
+int split_fanout(char *input, char **branches, int max_branches);
+void pump_fanout(int in_fd, int *outs, int n);
+
+// Script Mode
+int run_script(const char *path, int jobs);
+
 // Executor
-void execute_command(char **args);
+pid_t spawn_command(char **args, int in_fd, int out_fd, const sigset_t *sigmask, char **envp);
+
+// Thread Budgets
+void plan_thread_budgets(char **stage_args[], int num_stages, ThreadBudget *budgets);
+char **budget_env(const ThreadBudget *budget);
+void free_budget_env(char **env);
+void pin_for_stage(const ThreadBudget *budget);
+void restore_shell_affinity(void);
+void restrict_to_cpu_slice(int slot, int slots);
 
 // Shell
 void setup_shell(void);
 char **visionos_completion(const char *text, int start, int end);
 
 // Builtins
-int handle_builtin(char **args);
+int handle_builtin(char **args, int *status);
 
 // Memory Management
 void add_to_history(const char *command);
@@ -50,8 +79,31 @@ char** allocate_args(int count);
 void free_args(char **args);
 void print_memory_stats(void);
 
+// Image Cache
+void print_cache_stats(void);
+void clear_image_cache(void);
+
+// File Fingerprints
+int fingerprint_file(const char *path, uint64_t *digest, int *cached);
+int run_vhash(char **args);
+
+// Predictive Prewarming
+void setup_predictor(void);
+void predict_learn(const char *line);
+void prewarm_predicted(void);
+void predict_command_started(void);
+void predict_command_finished(void);
+void print_predictor_stats(void);
+
 // Signals
 void setup_signals(void);
 void set_foreground_pid(pid_t pid);
+void set_builtin_loop(int active);
+int builtin_interrupted(void);
+void setup_batch_signals(void);
+int batch_interrupted(void);
+
+// System Monitor
+int run_sysmon(char **args);
 
 #endif
\ No newline at end of file